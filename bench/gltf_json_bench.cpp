@@ -0,0 +1,117 @@
+// glTF manifest parsing: the streaming (SAX) loader against building the
+// full nlohmann DOM the loader used before, on a synthetic manifest with
+// many accessors, bufferViews and nodes.
+//
+// The DOM figure is nlohmann::json::parse alone; the old loader walked the
+// tree afterwards, so it is a lower bound for the old path.  The SAX figure
+// is the whole gltf::load (parse, node transforms, buffer mapping).
+//
+// Usage: ./gltf_json_bench [accessors]
+
+#include "gltfLoader/gltf.h"
+#include "gltfLoader/json.hpp"
+
+#include "Timer.hpp"
+#include "global.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+// Peak resident set size of the process so far, in MB.
+static double peak_rss_mb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+#else
+static double peak_rss_mb() { return 0; }
+#endif
+
+// One small buffer; every accessor is a single VEC3 in the same bufferView,
+// every tenth node carries a matrix and the rest a TRS.
+static void write_manifest(std::string const &path, size_t accessors) {
+    size_t nodes = accessors / 5;
+    std::ofstream bin("synthetic.bin", std::ios::binary);
+    float zero[3] = {0, 0, 0};
+    bin.write(reinterpret_cast<char const *>(zero), sizeof(zero));
+
+    std::ofstream out(path);
+    out << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"gltf_json_bench\"},";
+    out << "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],";
+    out << "\"buffers\":[{\"uri\":\"synthetic.bin\",\"byteLength\":12}],";
+    out << "\"bufferViews\":[";
+    for (size_t i = 0; i < accessors; ++i) {
+        out << (i ? "," : "")
+            << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":12,\"target\":34962}";
+    }
+    out << "],\"accessors\":[";
+    for (size_t i = 0; i < accessors; ++i) {
+        out << (i ? "," : "") << "{\"bufferView\":" << i
+            << ",\"componentType\":5126,\"count\":1,\"type\":\"VEC3\","
+               "\"min\":[-1.5,-2.25,-0.125],\"max\":[1.5,2.25,0.125]}";
+    }
+    out << "],\"nodes\":[{\"name\":\"root\",\"children\":[";
+    for (size_t i = 1; i < nodes; ++i) {
+        out << (i > 1 ? "," : "") << i;
+    }
+    out << "]}";
+    for (size_t i = 1; i < nodes; ++i) {
+        out << ",{\"name\":\"node_" << i << "\",";
+        if (i % 10 == 0) {
+            out << "\"matrix\":[1,0,0,0,0,1,0,0,0,0,1,0," << i * 0.5
+                << ",0.25,-3.75,1]}";
+        } else {
+            out << "\"translation\":[" << i * 0.5
+                << ",0.25,-3.75],\"rotation\":[0,0.7071068,0,0.7071068],"
+                   "\"scale\":[1,2,1]}";
+        }
+    }
+    out << "]}";
+}
+
+int main(int argc, char *argv[]) {
+    size_t accessors = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    std::string path = "synthetic.gltf";
+    write_manifest(path, accessors);
+
+    std::ifstream in(path);
+    in.seekg(0, std::ios::end);
+    msg("manifest: %zu accessors, %.1f MB of JSON\n", accessors, in.tellg() / (1024.0 * 1024.0));
+    in.seekg(0);
+
+    // SAX first: peak RSS only grows, so the DOM's extra memory shows up as
+    // the increase of the second measurement.
+    double rss_before = peak_rss_mb();
+    Timer t;
+    t.start();
+    gltf::Asset asset = gltf::load(path);
+    t.end();
+    double sax_ms = t.elapsedms();
+    double sax_rss = peak_rss_mb();
+
+    t.start();
+    nlohmann::json json = nlohmann::json::parse(in);
+    t.end();
+    double dom_ms = t.elapsedms();
+    double dom_rss = peak_rss_mb();
+
+    bool ok = asset.accessors.size() == json["accessors"].size() &&
+              asset.bufferViews.size() == json["bufferViews"].size() &&
+              asset.nodes.size() == json["nodes"].size();
+    msg("dom parse : %8.1f ms  peak RSS +%.1f MB\n", dom_ms, dom_rss - sax_rss);
+    msg("sax load  : %8.1f ms  peak RSS +%.1f MB  (%.1fx faster)\n", sax_ms,
+        sax_rss - rss_before, dom_ms / std::max(sax_ms, 1.0));
+    msg("asset %s\n", ok ? "verified" : "MISMATCH");
+
+    std::remove(path.c_str());
+    std::remove("synthetic.bin");
+    return ok ? 0 : 1;
+}
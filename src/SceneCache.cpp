@@ -0,0 +1,307 @@
+#include "SceneCache.hpp"
+#include "gltfLoader/MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <type_traits>
+
+namespace {
+
+    // 文件中各数组的顺序
+    enum Section : uint32_t {
+        Positions,      // float, vV
+        Normals,        // float, vnV
+        Indices,        // int32, iV
+        Geometries,     // GeometryRecord
+        Primitives,     // gltf::PrimitiveRange，按geometry依次排列
+        Instances,      // gltf::Instance
+        MeshesLength,   // int32，每个instance一个
+        OctreeNodes,    // FlatOctree::Node，按geometry依次排列，下标在各geometry内
+        OctreePrims,    // uint32，同上
+        SectionCount
+    };
+
+    struct GeometryRecord {
+        uint32_t mesh;
+        uint32_t primitiveCount;
+        uint64_t vertexOffset, vertexCount;
+        uint64_t indexOffset, indexCount;
+        uint64_t octreeNodes, octreePrims;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t weld;
+        float weldEpsilon;
+        uint32_t normals;       // vnV是否被解码
+        uint64_t key;
+        uint64_t decodedVertices;
+        // 各数组的元素大小，结构体布局（或flt）不同的构建产生的缓存因此不会被误用；
+        // 多出的一项为0，使count按8字节对齐
+        uint32_t recordSize[SectionCount + 1];
+        uint64_t count[SectionCount];
+    };
+
+    const char kMagic[8] = {'O', 'C', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+    static_assert(std::is_trivially_copyable<gltf::PrimitiveRange>::value, "PrimitiveRange is copied bytewise");
+    static_assert(std::is_trivially_copyable<gltf::Instance>::value, "Instance is copied bytewise");
+    static_assert(std::is_trivially_copyable<FlatOctree::Node>::value, "FlatOctree::Node is copied bytewise");
+
+    uint64_t align16(uint64_t offset) {
+        return (offset + 15) & ~uint64_t(15);
+    }
+
+    void fillHeader(Header& header, uint64_t key, const gltf::LoadOptions& options) {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kSceneCacheVersion;
+        header.weld = (uint32_t)options.weld;
+        // 不焊接或精确焊接时epsilon不影响结果
+        header.weldEpsilon = options.weld == gltf::LoadOptions::Weld::Quantized ? options.weldEpsilon : 0.0f;
+        header.normals = options.normals;
+        header.key = key;
+        const uint32_t sizes[SectionCount] = {
+            sizeof(float), sizeof(float), sizeof(int), sizeof(GeometryRecord), sizeof(gltf::PrimitiveRange),
+            sizeof(gltf::Instance), sizeof(int), sizeof(FlatOctree::Node), sizeof(uint32_t)};
+        std::memcpy(header.recordSize, sizes, sizeof(sizes));
+    }
+
+    // 映射中的一个数组，不做拷贝；越界时返回false
+    template <typename T>
+    bool mapSection(const gltf::MappedFile& file, uint64_t& offset, uint64_t count, const T*& out) {
+        offset = align16(offset);
+        if (offset > file.size() || count > (file.size() - offset) / sizeof(T)) {
+            return false;
+        }
+        out = reinterpret_cast<const T*>(file.data() + offset);
+        offset += count * sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    void writeSection(std::ofstream& fout, uint64_t& offset, const T* data, size_t count) {
+        static const char zeros[16] = {};
+        fout.write(zeros, align16(offset) - offset);
+        offset = align16(offset);
+        fout.write((const char*)data, count * sizeof(T));
+        offset += count * sizeof(T);
+    }
+
+    // 在path旁边新建一个只属于本次写入的临时文件，返回它的名字（失败时为空）。
+    // 名字带随机后缀，"x"模式在文件已存在时失败，同时写同一个缓存的进程互不覆盖
+    std::string createTemporary(const std::string& path) {
+        std::random_device random;
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            char suffix[32];
+            std::snprintf(suffix, sizeof(suffix), ".%08x.tmp", (unsigned)random());
+            std::string temporary = path + suffix;
+            if (FILE* file = std::fopen(temporary.c_str(), "wbx")) {
+                std::fclose(file);
+                return temporary;
+            }
+        }
+        return std::string();
+    }
+
+}
+
+bool loadSceneCache(const std::string& path, uint64_t key, const gltf::LoadOptions& options,
+                    gltf::Asset& asset, std::vector<FlatOctreeView>& octrees,
+                    std::shared_ptr<const void>& storage) {
+    std::shared_ptr<gltf::MappedFile> file;
+    try {
+        file = std::make_shared<gltf::MappedFile>(path);
+    } catch (const std::exception&) {
+        return false;
+    }
+    Header expected, header;
+    fillHeader(expected, key, options);
+    if (file->size() < sizeof(Header)) {
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(Header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(kMagic)) != 0 || header.version != expected.version
+        || header.weld != expected.weld || header.weldEpsilon != expected.weldEpsilon || header.normals != expected.normals
+        || header.key != expected.key
+        || std::memcmp(header.recordSize, expected.recordSize, sizeof(header.recordSize)) != 0) {
+        return false;
+    }
+
+    const float* vV = nullptr;
+    const float* vnV = nullptr;
+    const int* iV = nullptr;
+    const int* meshesLength = nullptr;
+    const GeometryRecord* geometries = nullptr;
+    const gltf::PrimitiveRange* primitives = nullptr;
+    const gltf::Instance* instances = nullptr;
+    const FlatOctree::Node* nodes = nullptr;
+    const uint32_t* prims = nullptr;
+    const uint64_t* count = header.count;
+    uint64_t offset = sizeof(Header);
+    if (!mapSection(*file, offset, count[Positions], vV) || !mapSection(*file, offset, count[Normals], vnV)
+        || !mapSection(*file, offset, count[Indices], iV)
+        || !mapSection(*file, offset, count[Geometries], geometries)
+        || !mapSection(*file, offset, count[Primitives], primitives)
+        || !mapSection(*file, offset, count[Instances], instances)
+        || !mapSection(*file, offset, count[MeshesLength], meshesLength)
+        || !mapSection(*file, offset, count[OctreeNodes], nodes)
+        || !mapSection(*file, offset, count[OctreePrims], prims)) {
+        return false;
+    }
+
+    // 逐项检查范围，损坏的缓存只会被当作未命中，不会越界访问
+    uint64_t vertexCount = count[Positions] / 3;
+    if (count[Positions] % 3 != 0 || count[Normals] != (header.normals ? count[Positions] : 0)
+        || count[MeshesLength] != count[Instances]) {
+        return false;
+    }
+    std::vector<gltf::Geometry> restored(count[Geometries]);
+    std::vector<FlatOctreeView> views(count[Geometries]);
+    uint64_t primitive = 0, node = 0, prim = 0;
+    for (size_t g = 0; g < restored.size(); ++g) {
+        const GeometryRecord& record = geometries[g];
+        if (record.mesh >= asset.meshes.size() || record.vertexOffset > vertexCount
+            || record.vertexCount > vertexCount - record.vertexOffset || record.indexOffset > count[Indices]
+            || record.indexCount > count[Indices] - record.indexOffset || record.indexCount % 3 != 0
+            || record.primitiveCount > count[Primitives] - primitive || record.octreeNodes > count[OctreeNodes] - node
+            || record.octreePrims > count[OctreePrims] - prim) {
+            return false;
+        }
+        for (uint64_t i = record.indexOffset; i < record.indexOffset + record.indexCount; ++i) {
+            if (iV[i] < 0 || (uint64_t)iV[i] < record.vertexOffset
+                || (uint64_t)iV[i] >= record.vertexOffset + record.vertexCount) {
+                return false;
+            }
+        }
+        gltf::Geometry& geometry = restored[g];
+        geometry.mesh = record.mesh;
+        geometry.vertexOffset = record.vertexOffset;
+        geometry.vertexCount = record.vertexCount;
+        geometry.indexOffset = record.indexOffset;
+        geometry.indexCount = record.indexCount;
+        geometry.primitives.assign(primitives + primitive, primitives + primitive + record.primitiveCount);
+        for (const gltf::PrimitiveRange& range : geometry.primitives) {
+            if (range.indexOffset < geometry.indexOffset || range.indexCount % 3 != 0
+                || range.indexOffset - geometry.indexOffset > geometry.indexCount
+                || range.indexCount > geometry.indexCount - (range.indexOffset - geometry.indexOffset)) {
+                return false;
+            }
+        }
+        FlatOctreeView& octree = views[g];
+        octree.nodes = nodes + node;
+        octree.nnodes = record.octreeNodes;
+        octree.prims = prims + prim;
+        octree.nprims = record.octreePrims;
+        if (!octree.valid(geometry.indexCount / 3)) {
+            return false;
+        }
+        primitive += record.primitiveCount;
+        node += record.octreeNodes;
+        prim += record.octreePrims;
+    }
+    for (uint64_t i = 0; i < count[Instances]; ++i) {
+        if (instances[i].node >= asset.nodes.size() || instances[i].geometry >= restored.size()) {
+            return false;
+        }
+    }
+
+    // asset拥有自己的数组，mesh数据只能复制出来；八叉树留在映射中
+    asset.vV.assign(vV, vV + count[Positions]);
+    asset.vnV.assign(vnV, vnV + count[Normals]);
+    asset.iV.assign(iV, iV + count[Indices]);
+    asset.geometries = std::move(restored);
+    asset.instances.assign(instances, instances + count[Instances]);
+    asset.meshesLength.assign(meshesLength, meshesLength + count[MeshesLength]);
+    asset.meshesName.clear();
+    for (const gltf::Instance& instance : asset.instances) {
+        asset.meshesName.push_back(asset.nodes[instance.node].name);
+    }
+    asset.statistics.decodedVertices = header.decodedVertices;
+    asset.statistics.vertices = vertexCount;
+    octrees = std::move(views);
+    storage = std::move(file);
+    return true;
+}
+
+bool saveSceneCache(const std::string& path, uint64_t key, const gltf::LoadOptions& options,
+                    const gltf::Asset& asset, const Scene& scene) {
+    if (scene.geometries.size() != asset.geometries.size()) {
+        return false;
+    }
+    Header header;
+    fillHeader(header, key, options);
+    header.decodedVertices = asset.statistics.decodedVertices;
+
+    std::vector<GeometryRecord> geometries;
+    std::vector<gltf::PrimitiveRange> primitives;
+    std::vector<FlatOctree::Node> nodes;
+    std::vector<uint32_t> prims;
+    for (size_t g = 0; g < asset.geometries.size(); ++g) {
+        const gltf::Geometry& geometry = asset.geometries[g];
+        FlatOctree octree = scene.flatten_octree(g);
+        GeometryRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.mesh = geometry.mesh;
+        record.primitiveCount = (uint32_t)geometry.primitives.size();
+        record.vertexOffset = geometry.vertexOffset;
+        record.vertexCount = geometry.vertexCount;
+        record.indexOffset = geometry.indexOffset;
+        record.indexCount = geometry.indexCount;
+        record.octreeNodes = octree.nodes.size();
+        record.octreePrims = octree.prims.size();
+        geometries.push_back(record);
+        primitives.insert(primitives.end(), geometry.primitives.begin(), geometry.primitives.end());
+        nodes.insert(nodes.end(), octree.nodes.begin(), octree.nodes.end());
+        prims.insert(prims.end(), octree.prims.begin(), octree.prims.end());
+    }
+    header.count[Positions] = asset.vV.size();
+    // --dump-obj时即使没有请求也会解码法线，不写入缓存
+    size_t normals = options.normals ? asset.vnV.size() : 0;
+    header.count[Normals] = normals;
+    header.count[Indices] = asset.iV.size();
+    header.count[Geometries] = geometries.size();
+    header.count[Primitives] = primitives.size();
+    header.count[Instances] = asset.instances.size();
+    header.count[MeshesLength] = asset.meshesLength.size();
+    header.count[OctreeNodes] = nodes.size();
+    header.count[OctreePrims] = prims.size();
+
+    std::string temporary = createTemporary(path);
+    if (temporary.empty()) {
+        return false;
+    }
+    {
+        std::ofstream fout(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fout) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        uint64_t offset = 0;
+        writeSection(fout, offset, &header, 1);
+        writeSection(fout, offset, asset.vV.data(), asset.vV.size());
+        writeSection(fout, offset, asset.vnV.data(), normals);
+        writeSection(fout, offset, asset.iV.data(), asset.iV.size());
+        writeSection(fout, offset, geometries.data(), geometries.size());
+        writeSection(fout, offset, primitives.data(), primitives.size());
+        writeSection(fout, offset, asset.instances.data(), asset.instances.size());
+        writeSection(fout, offset, asset.meshesLength.data(), asset.meshesLength.size());
+        writeSection(fout, offset, nodes.data(), nodes.size());
+        writeSection(fout, offset, prims.data(), prims.size());
+        if (!fout.flush()) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
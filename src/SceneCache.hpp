@@ -0,0 +1,54 @@
+#pragma once
+
+#include "gltfLoader/gltf.h"
+#include "Scene.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 场景缓存文件
+ *  Stores what occlusion culling needs from a loaded asset: the decoded
+ *  vV/vnV/iV, geometries with their primitive ranges, instances, and the
+ *  flattened octree of every geometry.  The file is a fixed header followed
+ *  by flat arrays at 16-byte aligned offsets on a read-only mapping.  A
+ *  cache hit copies the mesh arrays into the asset, which owns them, and
+ *  leaves the octrees on the mapping; the Scene assembles its triangles in
+ *  octree order straight from them.  Neither the buffers are decoded nor
+ *  the octrees built.
+ *
+ *  A cache is only used when its version, record layout, content hash (see
+ *  gltf::contentHash), weld and normals options all match; anything else
+ *  counts as a miss and the asset is loaded normally.
+ */
+
+// 格式变化时递增，旧版本的缓存文件会被当作未命中
+constexpr uint32_t kSceneCacheVersion = 5;
+
+/**
+ * @brief 从缓存恢复mesh数据
+ *  `asset` must have been loaded from the same file with
+ *  `meshData = false`; its vV/vnV/iV, geometries, instances, meshesLength,
+ *  meshesName and statistics are filled from the cache, and `octrees`
+ *  receives one flattened octree per geometry.  The octrees point into the
+ *  file's mapping, which `storage` keeps alive.
+ *
+ * @return false when the cache is missing, stale or malformed; `asset`,
+ *  `octrees` and `storage` are left unchanged then
+ */
+bool loadSceneCache(const std::string& path, uint64_t key, const gltf::LoadOptions& options,
+                    gltf::Asset& asset, std::vector<FlatOctreeView>& octrees,
+                    std::shared_ptr<const void>& storage);
+
+/**
+ * @brief 写入缓存
+ *  `scene` must have been built from `asset` with one Scene geometry per
+ *  glTF geometry.  The file is written next to `path` and renamed over it,
+ *  so a concurrent or interrupted run never sees a partial cache.
+ *
+ * @return false if the file can't be written
+ */
+bool saveSceneCache(const std::string& path, uint64_t key, const gltf::LoadOptions& options,
+                    const gltf::Asset& asset, const Scene& scene);
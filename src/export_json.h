@@ -69,14 +69,14 @@ namespace JSON{
         // nodes
         Json::Value nodes(Json::arrayValue);
         Json::Value child3;
-        for(int i=0;i<asset.newmeshesLength.size();i++)
+        for(int i=0;i<asset.newMeshes.size();i++)
             child3["children"].append(i+1);
         nodes[0] = child3 ;
 
-        for(int i=0;i<asset.newmeshesLength.size();i++){
+        for(int i=0;i<asset.newMeshes.size();i++){
             Json::Value child;
             child["mesh"] = i ;
-            child["name"] = asset.meshesName[i] ;
+            child["name"] = asset.newMeshes[i].name ;
             nodes[i+1] = child ;
         }
 
@@ -84,17 +84,19 @@ namespace JSON{
         cout<<"\nin here" ;
         // meshes
         Json::Value meshes(Json::arrayValue);
-        for(int i=0;i<asset.newmeshesLength.size();i++){
+        for(int i=0;i<asset.newMeshes.size();i++){
             cout<<"\nin here "<<i ;
             Json::Value child;
-            Json::Value child2 ;
-            Json::Value child3;
-            child3["POSITION"] = asset.newMeshes[i].primitives[0].attributes["POSITION"] ;
-            child2["indices"] = asset.newMeshes[i].primitives[0].indices ;
-            child2["attributes"] = Json::Value(child3) ;
-
-            child["primitives"].append(child2) ;
-            child["name"] = asset.meshesName[i] ;
+            // 与原mesh的primitive一一对应
+            for(auto &primitive : asset.newMeshes[i].primitives){
+                Json::Value child2 ;
+                Json::Value child3;
+                child3["POSITION"] = primitive.attributes["POSITION"] ;
+                child2["indices"] = primitive.indices ;
+                child2["attributes"] = Json::Value(child3) ;
+                child["primitives"].append(child2) ;
+            }
+            child["name"] = asset.newMeshes[i].name ;
 
             meshes[i] = child ;
              cout<<"\nin here   "<< i ;
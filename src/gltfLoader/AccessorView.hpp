@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "gltf.h"
+
+namespace gltf {
+
+    // componentType -> C++ 分量类型
+    template <uint32_t ComponentType> struct ComponentTraits;
+    template <> struct ComponentTraits<5120> { using type = int8_t; };
+    template <> struct ComponentTraits<5121> { using type = uint8_t; };
+    template <> struct ComponentTraits<5122> { using type = int16_t; };
+    template <> struct ComponentTraits<5123> { using type = uint16_t; };
+    template <> struct ComponentTraits<5125> { using type = uint32_t; };
+    template <> struct ComponentTraits<5126> { using type = float; };
+
+    // 归一化整数转float（glTF 2.0：c / max，有符号类型下限截到 -1）
+    template <typename T>
+    inline float normalizeComponent(T v) {
+        if constexpr (std::is_floating_point<T>::value) {
+            return v;
+        } else if constexpr (std::is_signed<T>::value) {
+            return std::max(float(v) / float(std::numeric_limits<T>::max()), -1.0f);
+        } else {
+            return float(v) / float(std::numeric_limits<T>::max());
+        }
+    }
+
+    /**
+     * @brief accessor的强类型视图
+     *  Offset, stride and component type are resolved once when the view is
+     *  made; element i, component c lives at data() + i * stride() + c *
+     *  sizeof(T).  Works for tightly packed and interleaved bufferViews
+     *  alike.  Matrix types of 1- and 2-byte components carry per-column
+     *  padding in glTF, which this view does not model.
+     */
+    template <typename T, size_t Components>
+    class AccessorView {
+    public:
+        using value_type = T;
+        static constexpr size_t components = Components;
+        static constexpr size_t elementSize = sizeof(T) * Components;
+
+        AccessorView(const uint8_t* data, size_t count, size_t stride)
+            : _data(data), _count(count), _stride(stride) {}
+
+        const uint8_t* data() const { return _data; }
+        size_t size() const { return _count; }
+        size_t stride() const { return _stride; }
+        // 分量之间没有间隔（非交错存储）
+        bool packed() const { return _stride == elementSize; }
+
+        T operator()(size_t i, size_t c) const {
+            T v;
+            std::memcpy(&v, _data + i * _stride + c * sizeof(T), sizeof(T));
+            return v;
+        }
+
+    private:
+        const uint8_t* _data;
+        size_t _count;
+        size_t _stride;
+    };
+
+    // 没有bufferView的accessor（元素全为0，通常是稀疏accessor）得到data()为nullptr的视图
+    template <typename T, size_t Components>
+    AccessorView<T, Components> makeAccessorView(const Asset& asset, uint32_t accessor) {
+        const Accessor& acc = asset.accessors[accessor];
+        if (acc.bufferView == -1) {
+            return AccessorView<T, Components>(nullptr, acc.count, sizeof(T) * Components);
+        }
+        const uint8_t* data = accessorData(asset, accessor);
+        uint32_t byteStride = asset.bufferViews[acc.bufferView].byteStride;
+        return AccessorView<T, Components>(data, acc.count, byteStride ? byteStride : sizeof(T) * Components);
+    }
+
+    // bufferView中紧密排列的count个元素（稀疏accessor的indices/values不使用byteStride）
+    template <typename T, size_t Components>
+    AccessorView<T, Components> makePackedView(const Asset& asset, int32_t bufferView, uint32_t byteOffset, size_t count) {
+        const size_t elementSize = sizeof(T) * Components;
+        const uint8_t* data = bufferViewData(asset, bufferView, byteOffset, (uint64_t)count * elementSize);
+        return AccessorView<T, Components>(data, count, elementSize);
+    }
+
+    /**
+     * @brief 遍历稀疏accessor的替换元素
+     *  Calls f(index, values, k) for the k-th substituted element, where
+     *  values is the AccessorView<T, Components> over the sparse values.
+     *  The sorted sparse index array is walked once; indices must be
+     *  strictly increasing and below the accessor's count.  Both views alias
+     *  the mapped buffer, nothing is copied.  Does nothing for a dense
+     *  accessor.
+     */
+    template <typename T, size_t Components, typename F>
+    void forEachSparse(const Asset& asset, uint32_t accessor, F&& f) {
+        const Accessor& acc = asset.accessors[accessor];
+        const Accessor::Sparse& sparse = acc.sparse;
+        if (!sparse.count) {
+            return;
+        }
+        const auto values = makePackedView<T, Components>(asset, sparse.values.bufferView, sparse.values.byteOffset, sparse.count);
+        auto walk = [&](const auto& indices) {
+            size_t next = 0;    // 严格递增：下一个索引的下界
+            for (size_t k = 0; k < indices.size(); ++k) {
+                size_t index = indices(k, 0);
+                if (index < next || index >= acc.count) {
+                    throw MisformattedException("accessors[i][sparse][indices]", "is not strictly increasing or is out of range");
+                }
+                next = index + 1;
+                f(index, values, k);
+            }
+        };
+        const int32_t bufferView = sparse.indices.bufferView;
+        const uint32_t byteOffset = sparse.indices.byteOffset;
+        switch (sparse.indices.componentType) {
+            case 5121: walk(makePackedView<uint8_t, 1>(asset, bufferView, byteOffset, sparse.count)); break;
+            case 5123: walk(makePackedView<uint16_t, 1>(asset, bufferView, byteOffset, sparse.count)); break;
+            case 5125: walk(makePackedView<uint32_t, 1>(asset, bufferView, byteOffset, sparse.count)); break;
+            default: throw MisformattedException("accessors[i][sparse][indices][componentType]", "is not a valid index type");
+        }
+    }
+
+    /**
+     * @brief 按componentType分派
+     *  Calls f with the AccessorView<T, Components> matching the accessor's
+     *  componentType, so the body of f is compiled once per component type
+     *  and contains no per-element type switch.
+     */
+    template <size_t Components, typename F>
+    void visitComponentType(const Asset& asset, uint32_t accessor, F&& f) {
+        if (componentCount(asset.accessors[accessor].type) != Components) {
+            throw MisformattedException("accessors[i][type]", "has an unexpected number of components");
+        }
+        switch (asset.accessors[accessor].componentType) {
+            case 5120: f(makeAccessorView<ComponentTraits<5120>::type, Components>(asset, accessor)); break;
+            case 5121: f(makeAccessorView<ComponentTraits<5121>::type, Components>(asset, accessor)); break;
+            case 5122: f(makeAccessorView<ComponentTraits<5122>::type, Components>(asset, accessor)); break;
+            case 5123: f(makeAccessorView<ComponentTraits<5123>::type, Components>(asset, accessor)); break;
+            case 5125: f(makeAccessorView<ComponentTraits<5125>::type, Components>(asset, accessor)); break;
+            case 5126: f(makeAccessorView<ComponentTraits<5126>::type, Components>(asset, accessor)); break;
+            default: throw MisformattedException("accessors[i][componentType]", "is not a valid component type");
+        }
+    }
+
+    // 按 (componentType, type) 分派到具体的 AccessorView<T, Components>
+    template <typename F>
+    void visitAccessor(const Asset& asset, uint32_t accessor, F&& f) {
+        switch (asset.accessors[accessor].type) {
+            case Accessor::Type::Scalar: visitComponentType<1>(asset, accessor, f); break;
+            case Accessor::Type::Vec2: visitComponentType<2>(asset, accessor, f); break;
+            case Accessor::Type::Vec3: visitComponentType<3>(asset, accessor, f); break;
+            case Accessor::Type::Vec4: visitComponentType<4>(asset, accessor, f); break;
+            case Accessor::Type::Mat2: visitComponentType<4>(asset, accessor, f); break;
+            case Accessor::Type::Mat3: visitComponentType<9>(asset, accessor, f); break;
+            case Accessor::Type::Mat4: visitComponentType<16>(asset, accessor, f); break;
+        }
+    }
+
+    // 转成紧密排列的float；T、Components、Normalized 都是编译期常量，循环内无分支
+    template <bool Normalized, typename T, size_t Components>
+    void decodeFloats(const AccessorView<T, Components>& view, float* out) {
+        if (!view.data()) {
+            std::fill(out, out + view.size() * Components, 0.0f);
+            return;
+        }
+        if (std::is_same<T, float>::value && view.packed()) {
+            std::memcpy(out, view.data(), view.size() * view.elementSize);
+            return;
+        }
+        const uint8_t* src = view.data();
+        const size_t stride = view.stride();
+        for (size_t i = 0; i < view.size(); ++i, src += stride, out += Components) {
+            for (size_t c = 0; c < Components; ++c) {
+                T v;
+                std::memcpy(&v, src + c * sizeof(T), sizeof(T));
+                out[c] = Normalized ? normalizeComponent(v) : float(v);
+            }
+        }
+    }
+
+    /**
+     * @brief 把accessor解码为 count * Components 个float
+     *  Any component type is accepted; normalized integer accessors are
+     *  mapped to [0, 1] / [-1, 1] as the glTF spec requires.  Sparse
+     *  substitutions are written over the decoded dense data in out.
+     */
+    template <size_t Components>
+    void decodeFloats(const Asset& asset, uint32_t accessor, float* out) {
+        bool normalized = asset.accessors[accessor].normalized;
+        visitComponentType<Components>(asset, accessor, [&](const auto& view) {
+            using T = typename std::decay<decltype(view)>::type::value_type;
+            if (normalized) {
+                decodeFloats<true>(view, out);
+            } else {
+                decodeFloats<false>(view, out);
+            }
+            forEachSparse<T, Components>(asset, accessor, [&](size_t index, const auto& values, size_t k) {
+                float* dst = out + index * Components;
+                for (size_t c = 0; c < Components; ++c) {
+                    dst[c] = normalized ? normalizeComponent(values(k, c)) : float(values(k, c));
+                }
+            });
+        });
+    }
+
+    // 按mode展开后的三角形个数（points/lines没有三角形）
+    inline size_t triangleCount(Primitive::Mode mode, size_t count) {
+        switch (mode) {
+            case Primitive::Mode::Triangles: return count / 3;
+            case Primitive::Mode::TriangleStrip:
+            case Primitive::Mode::TriangleFan: return count >= 3 ? count - 2 : 0;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief 把count个顶点索引按mode展开成三角形列表
+     *  index(i) returns the i-th vertex index of the primitive; offset is
+     *  added to every index written.  Strips and fans are converted in one
+     *  linear pass with the winding given by the glTF spec, so every output
+     *  triangle faces the same way as in the source primitive.
+     */
+    template <typename Index>
+    void emitTriangles(Primitive::Mode mode, size_t count, const Index& index, int offset, int* out) {
+        const size_t n = triangleCount(mode, count);
+        switch (mode) {
+            case Primitive::Mode::Triangles:
+                for (size_t i = 0; i < n * 3; ++i) {
+                    out[i] = static_cast<int>(index(i)) + offset;
+                }
+                break;
+            case Primitive::Mode::TriangleStrip:
+                // 第i个三角形：p_i, p_{i+1+i%2}, p_{i+2-i%2}
+                for (size_t i = 0; i < n; ++i, out += 3) {
+                    size_t odd = i & 1;
+                    out[0] = static_cast<int>(index(i)) + offset;
+                    out[1] = static_cast<int>(index(i + 1 + odd)) + offset;
+                    out[2] = static_cast<int>(index(i + 2 - odd)) + offset;
+                }
+                break;
+            case Primitive::Mode::TriangleFan:
+                // 第i个三角形：p_{i+1}, p_{i+2}, p_0
+                for (size_t i = 0; i < n; ++i, out += 3) {
+                    out[0] = static_cast<int>(index(i + 1)) + offset;
+                    out[1] = static_cast<int>(index(i + 2)) + offset;
+                    out[2] = static_cast<int>(index(0)) + offset;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // 索引必须落在primitive的顶点范围内，否则后续按索引取顶点会越界
+    inline uint32_t checkedIndex(uint32_t index, size_t vertexCount) {
+        if (index >= vertexCount) {
+            throw MisformattedException("accessors[i]", "holds a vertex index out of range of the primitive's vertices");
+        }
+        return index;
+    }
+
+    /**
+     * @brief 读取primitive的三角形索引并加上offset
+     *  indices is the index accessor, or -1 for a non-indexed primitive whose
+     *  vertices are used in order.  Writes triangleCount(mode, n) * 3 ints.
+     *  Sparse substitutions are patched into the output of a triangle list
+     *  directly; strips and fans resolve the substituted indices first.
+     *  Every index, substituted or not, is checked against vertexCount and
+     *  a MisformattedException is thrown when one is out of range.
+     */
+    inline void decodeTriangles(const Asset& asset, int32_t indices, size_t vertexCount,
+                                Primitive::Mode mode, int offset, int* out) {
+        if (indices < 0) {
+            emitTriangles(mode, vertexCount, [](size_t i) { return static_cast<uint32_t>(i); }, offset, out);
+            return;
+        }
+        const Accessor& acc = asset.accessors[indices];
+        auto emit = [&](const auto& view) {
+            using T = typename std::decay<decltype(view)>::type::value_type;
+            auto at = [&view, vertexCount](size_t i) { return checkedIndex(view(i, 0), vertexCount); };
+            if (!acc.sparse.count && view.data()) {
+                emitTriangles(mode, view.size(), at, offset, out);
+                return;
+            }
+            // 三角形列表的第i个输出就是第i个索引，替换的索引直接写到out上
+            if (mode == Primitive::Mode::Triangles) {
+                const size_t n = triangleCount(mode, view.size()) * 3;
+                if (view.data()) {
+                    emitTriangles(mode, view.size(), at, offset, out);
+                } else if (n) {
+                    std::fill(out, out + n, static_cast<int>(checkedIndex(0, vertexCount)) + offset);
+                }
+                forEachSparse<T, 1>(asset, indices, [&](size_t index, const auto& values, size_t k) {
+                    if (index < n) {
+                        out[index] = static_cast<int>(checkedIndex(values(k, 0), vertexCount)) + offset;
+                    }
+                });
+                return;
+            }
+            std::vector<uint32_t> resolved(view.size(), 0);
+            if (view.data()) {
+                for (size_t i = 0; i < resolved.size(); ++i) {
+                    resolved[i] = view(i, 0);
+                }
+            }
+            forEachSparse<T, 1>(asset, indices, [&](size_t index, const auto& values, size_t k) {
+                resolved[index] = values(k, 0);
+            });
+            emitTriangles(mode, resolved.size(),
+                          [&resolved, vertexCount](size_t i) { return checkedIndex(resolved[i], vertexCount); },
+                          offset, out);
+        };
+        switch (asset.accessors[indices].componentType) {
+            case 5121: emit(makeAccessorView<uint8_t, 1>(asset, indices)); break;
+            case 5123: emit(makeAccessorView<uint16_t, 1>(asset, indices)); break;
+            case 5125: emit(makeAccessorView<uint32_t, 1>(asset, indices)); break;
+            default: throw MisformattedException("accessors[i][componentType]", "is not a valid index type");
+        }
+    }
+
+}
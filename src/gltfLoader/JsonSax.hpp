@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+
+namespace gltf {
+
+    // JSON语法错误，offset为出错位置（字节）
+    inline void throwJsonSyntaxError(const char* begin, const char* p) {
+        throw MisformattedException("json", "has a syntax error at byte " + std::to_string(p - begin));
+    }
+
+    // 解析4位十六进制数，p指向第一位
+    inline uint32_t parseJsonHex4(const char* begin, const char* p, const char* end) {
+        if (end - p < 4) {
+            throwJsonSyntaxError(begin, p);
+        }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = p[i];
+            v <<= 4;
+            if (c >= '0' && c <= '9') {
+                v |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                v |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                v |= c - 'A' + 10;
+            } else {
+                throwJsonSyntaxError(begin, p + i);
+            }
+        }
+        return v;
+    }
+
+    inline void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += char(cp);
+        } else if (cp < 0x800) {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        } else {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // p指向开头的引号；解析后的内容写入out，返回结尾引号之后的位置
+    inline const char* parseJsonString(const char* begin, const char* p, const char* end, std::string& out) {
+        out.clear();
+        const char* run = ++p;  // 没有转义的一段直接整段拷贝
+        while (true) {
+            if (p == end) {
+                throwJsonSyntaxError(begin, p);
+            }
+            char c = *p;
+            if (c == '"') {
+                out.append(run, p);
+                return p + 1;
+            }
+            if ((unsigned char)c < 0x20) {
+                throwJsonSyntaxError(begin, p);
+            }
+            if (c != '\\') {
+                ++p;
+                continue;
+            }
+            out.append(run, p);
+            if (++p == end) {
+                throwJsonSyntaxError(begin, p);
+            }
+            switch (*p++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp = parseJsonHex4(begin, p, end);
+                    p += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        // UTF-16代理对
+                        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') {
+                            throwJsonSyntaxError(begin, p);
+                        }
+                        uint32_t low = parseJsonHex4(begin, p + 2, end);
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            throwJsonSyntaxError(begin, p);
+                        }
+                        p += 6;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        throwJsonSyntaxError(begin, p);
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    throwJsonSyntaxError(begin, p - 1);
+            }
+            run = p;
+        }
+    }
+
+    // p指向数字的第一个字符；结果写入value，返回数字之后的位置
+    // 有效数字不超过2^53、十进制指数不超过22时，m * 10^e 或 m / 10^-e 只有一次舍入，
+    // 结果与strtod相同（Clinger快速路径）；其余情况仍交给strtod
+    inline const char* parseJsonNumber(const char* begin, const char* p, const char* end, double& value) {
+        static const double kPow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+        };
+        auto isDigit = [end](const char* q) { return q != end && *q >= '0' && *q <= '9'; };
+
+        const char* start = p;
+        bool negative = false;
+        if (*p == '-') {
+            negative = true;
+            ++p;
+        }
+        if (!isDigit(p)) {
+            throwJsonSyntaxError(begin, p);
+        }
+        // 整数和小数部分的数字顺便累加到mantissa
+        uint64_t mantissa = 0;
+        int digits = 0;         // 累加进mantissa的有效数字个数
+        int exponent = 0;
+        if (*p == '0') {
+            ++p;
+        } else {
+            for (; isDigit(p); ++p, ++digits) {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+        }
+        if (p != end && *p == '.') {
+            if (!isDigit(++p)) {
+                throwJsonSyntaxError(begin, p);
+            }
+            for (; isDigit(p); ++p, --exponent) {
+                if (mantissa != 0 || *p != '0') {
+                    ++digits;
+                }
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+        }
+        if (p != end && (*p == 'e' || *p == 'E')) {
+            bool negativeExponent = false;
+            if (++p != end && (*p == '+' || *p == '-')) {
+                negativeExponent = *p++ == '-';
+            }
+            if (!isDigit(p)) {
+                throwJsonSyntaxError(begin, p);
+            }
+            int e = 0;
+            for (; isDigit(p); ++p) {
+                if (e < 100000) {
+                    e = e * 10 + (*p - '0');
+                }
+            }
+            exponent += negativeExponent ? -e : e;
+        }
+        if (digits <= 19 && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            double m = double(mantissa);
+            value = exponent < 0 ? m / kPow10[-exponent] : m * kPow10[exponent];
+            if (negative) {
+                value = -value;
+            }
+            return p;
+        }
+        // 输入不以'\0'结尾，拷贝出来再交给strtod
+        char buffer[64];
+        size_t length = p - start;
+        if (length < sizeof(buffer)) {
+            std::copy(start, p, buffer);
+            buffer[length] = '\0';
+            value = std::strtod(buffer, nullptr);
+        } else {
+            value = std::strtod(std::string(start, p).c_str(), nullptr);
+        }
+        return p;
+    }
+
+    /**
+     * @brief 流式（SAX）解析JSON
+     *  Walks [begin, end) once and reports every token to the handler:
+     *  null(), boolean(bool), number(double), string(std::string&),
+     *  start_object(), key(std::string&), end_object(), start_array() and
+     *  end_array().  No tree is built; the strings passed to the handler are
+     *  scratch buffers that it may move from.  Nesting is tracked on an
+     *  explicit stack, so deep documents cannot overflow the call stack.
+     *  Malformed input throws MisformattedException.
+     */
+    template <typename Handler>
+    void parseJson(const char* begin, const char* end, Handler& handler) {
+        auto skipWhitespace = [end](const char* p) {
+            while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+                ++p;
+            }
+            return p;
+        };
+        auto literal = [begin, end](const char* p, const char* word, size_t length) {
+            if (size_t(end - p) < length || std::string::traits_type::compare(p, word, length) != 0) {
+                throwJsonSyntaxError(begin, p);
+            }
+            return p + length;
+        };
+
+        const char* p = begin;
+        // UTF-8 BOM
+        if (end - p >= 3 && (unsigned char)p[0] == 0xEF && (unsigned char)p[1] == 0xBB && (unsigned char)p[2] == 0xBF) {
+            p += 3;
+        }
+
+        std::vector<char> stack;   // '{' 或 '['
+        std::string text;
+        bool expectKey = false;
+        while (true) {
+            p = skipWhitespace(p);
+            if (p == end) {
+                throwJsonSyntaxError(begin, p);
+            }
+
+            if (expectKey) {
+                if (*p != '"') {
+                    throwJsonSyntaxError(begin, p);
+                }
+                p = parseJsonString(begin, p, end, text);
+                handler.key(text);
+                p = skipWhitespace(p);
+                if (p == end || *p != ':') {
+                    throwJsonSyntaxError(begin, p);
+                }
+                p = skipWhitespace(p + 1);
+                if (p == end) {
+                    throwJsonSyntaxError(begin, p);
+                }
+                expectKey = false;
+            }
+
+            // 一个值
+            switch (*p) {
+                case '{':
+                    handler.start_object();
+                    p = skipWhitespace(p + 1);
+                    if (p != end && *p == '}') {
+                        handler.end_object();
+                        ++p;
+                        break;
+                    }
+                    stack.push_back('{');
+                    expectKey = true;
+                    continue;
+                case '[':
+                    handler.start_array();
+                    p = skipWhitespace(p + 1);
+                    if (p != end && *p == ']') {
+                        handler.end_array();
+                        ++p;
+                        break;
+                    }
+                    stack.push_back('[');
+                    continue;
+                case '"':
+                    p = parseJsonString(begin, p, end, text);
+                    handler.string(text);
+                    break;
+                case 't':
+                    p = literal(p, "true", 4);
+                    handler.boolean(true);
+                    break;
+                case 'f':
+                    p = literal(p, "false", 5);
+                    handler.boolean(false);
+                    break;
+                case 'n':
+                    p = literal(p, "null", 4);
+                    handler.null();
+                    break;
+                default: {
+                    double value;
+                    p = parseJsonNumber(begin, p, end, value);
+                    handler.number(value);
+                    break;
+                }
+            }
+
+            // 值之后：逗号、或者关闭一层或多层容器
+            while (true) {
+                p = skipWhitespace(p);
+                if (stack.empty()) {
+                    if (p != end) {
+                        throwJsonSyntaxError(begin, p);
+                    }
+                    return;
+                }
+                if (p == end) {
+                    throwJsonSyntaxError(begin, p);
+                }
+                if (*p == ',') {
+                    ++p;
+                    expectKey = stack.back() == '{';
+                    break;
+                }
+                if (*p == '}' && stack.back() == '{') {
+                    handler.end_object();
+                } else if (*p == ']' && stack.back() == '[') {
+                    handler.end_array();
+                } else {
+                    throwJsonSyntaxError(begin, p);
+                }
+                stack.pop_back();
+                ++p;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,109 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gltf {
+
+#ifdef _WIN32
+
+    MappedFile::MappedFile(const std::string& path) {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("can't open file: " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("can't stat file: " + path);
+        }
+        _file = file;
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0) {
+            return;
+        }
+        _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("can't map file: " + path);
+        }
+        _data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_data) {
+            CloseHandle(_mapping);
+            CloseHandle(file);
+            throw std::runtime_error("can't map file: " + path);
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping) {
+            CloseHandle(_mapping);
+        }
+        if (_file) {
+            CloseHandle(_file);
+        }
+    }
+
+    void MappedFile::prefetch() const {
+#if _WIN32_WINNT >= 0x0602
+        if (_data) {
+            WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(_data), _size};
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+#endif
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("can't open file: " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("can't stat file: " + path);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size == 0) {
+            close(fd);
+            return;
+        }
+        void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // 映射建立后文件描述符就不再需要了
+        close(fd);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("can't map file: " + path);
+        }
+        _data = static_cast<const uint8_t*>(p);
+    }
+
+    MappedFile::~MappedFile() {
+        if (_data) {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+    }
+
+    void MappedFile::prefetch() const {
+        // MADV_WILLNEED只发起预读，不等待I/O完成
+        if (_data) {
+            madvise(const_cast<uint8_t*>(_data), _size, MADV_WILLNEED);
+        }
+    }
+
+#endif
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gltf {
+
+    /**
+     * @brief 只读内存映射文件
+     *  Maps a whole file read-only into the address space.  The mapping is
+     *  released when the object is destroyed, so anything pointing into
+     *  data() must keep the MappedFile alive (Buffer does this through a
+     *  shared_ptr).
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return _data; }
+        size_t size() const { return _size; }
+
+        // 提示系统异步预读整个文件，立即返回；之后访问data()时缺页更少
+        void prefetch() const;
+
+    private:
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+#ifdef _WIN32
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+#endif
+    };
+
+}
@@ -0,0 +1,181 @@
+#include "base64.hpp"
+
+#include <array>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GLTF_BASE64_X86 1
+#include <immintrin.h>
+#endif
+
+namespace gltf {
+
+    // 字符 -> 6位值，非法字符为0xff
+    static const std::array<uint8_t, 256> kDecodeTable = [] {
+        std::array<uint8_t, 256> table{};
+        table.fill(0xff);
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (uint8_t i = 0; i < 64; ++i) {
+            table[(uint8_t)alphabet[i]] = i;
+        }
+        return table;
+    }();
+
+    static size_t stripPadding(const char* src, size_t length) {
+        if (length > 0 && src[length - 1] == '=') --length;
+        if (length > 0 && src[length - 1] == '=') --length;
+        return length;
+    }
+
+    size_t base64DecodedSize(const char* src, size_t length) {
+        length = stripPadding(src, length);
+        return length / 4 * 3 + (length % 4 ? length % 4 - 1 : 0);
+    }
+
+    // 不含填充字符的输入
+    static bool decodeUnpadded(const char* src, size_t length, uint8_t* dst) {
+        if (length % 4 == 1) {
+            return false;
+        }
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+        size_t i = 0;
+        for (; i + 4 <= length; i += 4) {
+            uint32_t a = kDecodeTable[in[i]], b = kDecodeTable[in[i + 1]];
+            uint32_t c = kDecodeTable[in[i + 2]], d = kDecodeTable[in[i + 3]];
+            if ((a | b | c | d) & 0x80) {
+                return false;
+            }
+            uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+            dst[0] = (uint8_t)(v >> 16);
+            dst[1] = (uint8_t)(v >> 8);
+            dst[2] = (uint8_t)v;
+            dst += 3;
+        }
+        // 尾部2或3个字符 -> 1或2个字节
+        if (i < length) {
+            uint32_t v = 0;
+            size_t rest = length - i;
+            for (size_t k = 0; k < rest; ++k) {
+                uint32_t x = kDecodeTable[in[i + k]];
+                if (x & 0x80) {
+                    return false;
+                }
+                v |= x << (18 - 6 * k);
+            }
+            dst[0] = (uint8_t)(v >> 16);
+            if (rest == 3) {
+                dst[1] = (uint8_t)(v >> 8);
+            }
+        }
+        return true;
+    }
+
+    bool decodeBase64Scalar(const char* src, size_t length, uint8_t* dst) {
+        return decodeUnpadded(src, stripPadding(src, length), dst);
+    }
+
+#ifdef GLTF_BASE64_X86
+
+    /*
+     * SIMD kernels after Muła & Lemire, "Faster Base64 Encoding and Decoding
+     * using AVX2 Instructions".  Every character is validated with two
+     * nibble-indexed lookups (a character is invalid iff lutLo[lo] &
+     * lutHi[hi] != 0), translated to its 6-bit value by adding a per-range
+     * offset, and groups of four 6-bit values are packed into three bytes
+     * with two multiply-add instructions.
+     */
+
+    __attribute__((target("ssse3")))
+    static size_t decodeSsse3(const uint8_t* src, size_t length, uint8_t* dst) {
+        const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i slash = _mm_set1_epi8('/');
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16, dst += 12) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+            __m128i lo = _mm_and_si128(in, nibble);
+            __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, lo), _mm_shuffle_epi8(lutHi, hi));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff) {
+                break;
+            }
+            __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, slash), hi));
+            __m128i values = _mm_add_epi8(in, roll);
+            __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i out = _mm_shuffle_epi8(_mm_madd_epi16(merged, _mm_set1_epi32(0x00011000)), pack);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), out);
+            uint32_t tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+            dst[8] = (uint8_t)tail;
+            dst[9] = (uint8_t)(tail >> 8);
+            dst[10] = (uint8_t)(tail >> 16);
+            dst[11] = (uint8_t)(tail >> 24);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    static size_t decodeAvx2(const uint8_t* src, size_t length, uint8_t* dst) {
+        const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                               0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                                 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71,
+                                                 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i slash = _mm256_set1_epi8('/');
+        const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32, dst += 24) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble);
+            __m256i lo = _mm256_and_si256(in, nibble);
+            if (!_mm256_testz_si256(_mm256_shuffle_epi8(lutLo, lo), _mm256_shuffle_epi8(lutHi, hi))) {
+                break;
+            }
+            __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, slash), hi));
+            __m256i values = _mm256_add_epi8(in, roll);
+            __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            __m256i out = _mm256_shuffle_epi8(_mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000)), pack);
+            out = _mm256_permutevar8x32_epi32(out, gather);
+            // 只写24个有效字节，不越过dst的末尾
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(out));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), _mm256_extracti128_si256(out, 1));
+        }
+        return i;
+    }
+
+#endif
+
+    bool decodeBase64(const char* src, size_t length, uint8_t* dst) {
+        length = stripPadding(src, length);
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+        size_t done = 0;
+#ifdef GLTF_BASE64_X86
+        // SIMD内核遇到非法字符时提前返回，剩余部分交给标量代码报错
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+        static const bool hasSsse3 = __builtin_cpu_supports("ssse3");
+        if (hasAvx2) {
+            done = decodeAvx2(in, length, dst);
+        } else if (hasSsse3) {
+            done = decodeSsse3(in, length, dst);
+        }
+#endif
+        return decodeUnpadded(src + done, length - done, dst + done / 4 * 3);
+    }
+
+}
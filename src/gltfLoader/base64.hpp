@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gltf {
+
+    // 解码后的字节数（去掉末尾的'='填充）
+    size_t base64DecodedSize(const char* src, size_t length);
+
+    /**
+     * @brief base64解码
+     *  Decodes `length` characters of standard base64 (RFC 4648 alphabet,
+     *  optional '=' padding) into `dst`, which must hold at least
+     *  base64DecodedSize(src, length) bytes.  Uses an AVX2 or SSSE3 kernel
+     *  when the CPU supports one and a table-driven scalar loop otherwise.
+     *
+     * @return false if the input contains a character outside the alphabet
+     */
+    bool decodeBase64(const char* src, size_t length, uint8_t* dst);
+
+    // 纯标量实现（SIMD内核处理不了的尾部也走这里）
+    bool decodeBase64Scalar(const char* src, size_t length, uint8_t* dst);
+
+}
@@ -1,539 +1,909 @@
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
 #include <fstream>
 #include <string>
-#include "json.hpp"
 #include "gltf.h"
 #include "Exceptions.hpp"
+#include "MappedFile.hpp"
+#include "base64.hpp"
+#include "meshopt.hpp"
+#include "AccessorView.hpp"
+#include "JsonSax.hpp"
+#include "ThreadPool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GLTF_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace gltf {
+
+    // GLB容器中的BIN块；读取.gltf文件时data为空
+    struct BinaryChunk {
+        const uint8_t* data = nullptr;
+        uint64_t byteLength = 0;
+        std::shared_ptr<MappedFile> file;
+    };
     
-    static void loadAsset(Asset& asset, nlohmann::json& json);
-    static void loadScenes(Asset& asset, nlohmann::json& json);
-    static void loadMeshes(Asset& asset, nlohmann::json& json);
-    static void loadNodes(Asset& asset, nlohmann::json& json);
-
-    static void loadBuffers(Asset& asset, nlohmann::json& json);
-    static void loadAccessors(Asset& asset, nlohmann::json& json);
-    static void loadBufferViews(Asset& asset, nlohmann::json& json);
+    static void loadBuffers(Asset& asset, const BinaryChunk& bin);
     static void loadBufferData(Asset& asset, Buffer& buffer);
-
-
-    // 加载 metadata （version、copyright、generator）
-    static void loadAsset(Asset& asset, nlohmann::json& json){
-        if (json.find("asset") == json.end()) {
-            throw MisformattedExceptionIsRequired("asset");
-        }
-         // version
-        if (json["asset"].find("version") == json["asset"].end()) {
-            throw MisformattedExceptionIsRequired("asset[version]");
-        }
-        if (!json["asset"]["version"].is_string()) {
-            throw MisformattedExceptionNotString("version");
-        }
-        asset.metadata.version = json["asset"]["version"].get<std::string>();
-
-        // copyright
-        if (json["asset"].find("copyright") != json["asset"].end()) {
-            if (!json["asset"]["copyright"].is_string()) {
-                throw MisformattedExceptionNotString("copyright");
+    static void decodeMeshoptBufferViews(Asset& asset);
+    static void loadMeshData(Asset& asset, const LoadOptions& options);
+    static void computeWorldTransforms(Asset& asset);
+
+
+    // T*R*S，按glTF的列主序写入Matrix（Matrix[12..14]为平移）
+    // R为单位四元数 (x, y, z, w)
+    static void localTransform(const float T[3],const float R[4],const float S[3],float(&Matrix)[16]){
+        float x=R[0], y=R[1], z=R[2], w=R[3];
+        const float rot[9] = {
+            1-2*(y*y+z*z), 2*(x*y+w*z),   2*(x*z-w*y),      // 第0列
+            2*(x*y-w*z),   1-2*(x*x+z*z), 2*(y*z+w*x),      // 第1列
+            2*(x*z+w*y),   2*(y*z-w*x),   1-2*(x*x+y*y),    // 第2列
+        };
+        for(int c=0;c<3;c++){
+            for(int r=0;r<3;r++){
+                Matrix[c*4+r] = rot[c*3+r]*S[c];
             }
-
-            asset.metadata.copyright = json["asset"]["copyright"].get<std::string>();
-        }
-
-        // generator
-        if (json["asset"].find("generator") != json["asset"].end()) {
-            if (!json["asset"]["generator"].is_string()) {
-                throw MisformattedExceptionNotString("generator");
-            }
-
-            asset.metadata.generator = json["asset"]["generator"].get<std::string>();
+            Matrix[c*4+3] = 0.0f;
         }
+        Matrix[12]=T[0]; Matrix[13]=T[1]; Matrix[14]=T[2]; Matrix[15]=1.0f;
     }
-    
-    // 加载scenes （通常只包含一个场景，由nodes数组组成） 
-    static void loadScenes(Asset& asset, nlohmann::json& json){
 
-        if (json.find("scene") != json.end()) {
-            if (!json["scene"].is_number()) {
-                throw MisformattedExceptionNotNumber("scene");
+    // 列主序矩阵乘法 out = a * b（out不能与a、b重叠）
+    static void multiplyMatrix(const float a[16], const float b[16], float out[16]){
+        for(int c=0;c<4;c++){
+            for(int r=0;r<4;r++){
+                out[c*4+r] = a[r]*b[c*4] + a[4+r]*b[c*4+1] + a[8+r]*b[c*4+2] + a[12+r]*b[c*4+3];
             }
-            asset.scene = json["scene"].get<int32_t>();
         }
-        if (json.find("scenes") == json.end()) {
-        return;
     }
 
-        auto& scenes = json["scenes"];
-        if (!scenes.is_array()) {
-            throw MisformattedExceptionNotArray("scenes");
+    /**
+     * @brief 把glTF的JSON逐个token直接写入Asset（SAX）
+     *  parseJson reports tokens in document order; the handler keeps one
+     *  frame per open object/array saying which part of the glTF it is in,
+     *  and every value is stored as soon as it is seen.  Array elements are
+     *  appended to the Asset vectors, so the current element is always
+     *  back().  Subtrees the loader does not read (unknown extensions, extras,
+     *  materials, ...) are skipped.  Missing and mistyped fields raise the
+     *  same Misformatted* exceptions the DOM walk did.
+     */
+    class GltfSaxHandler {
+    public:
+        explicit GltfSaxHandler(Asset& asset) : asset(asset) {}
+
+        void null() { _value(Value::Null); }
+        void boolean(bool b) { boolValue = b; _value(Value::Boolean); }
+        void number(double n) { numberValue = n; _value(Value::Number); }
+        void string(std::string& s) { stringValue = &s; _value(Value::String); }
+        void start_object() { _value(Value::Object); }
+        void start_array() { _value(Value::Array); }
+        void key(std::string& k) { currentKey.swap(k); }
+        void end_object() { _close(); }
+        void end_array() { _close(); }
+
+    private:
+        enum class Value : uint8_t { Null, Boolean, Number, String, Object, Array };
+
+        // 当前所在的对象/数组
+        enum class Context : uint8_t {
+            Skip, Root, Asset, Scenes, Scene, SceneNodes, Meshes, Mesh, Primitives, Primitive, Attributes,
+            Nodes, Node, NodeChildren, NodeFloats, Buffers, Buffer, BufferViews, BufferView, Accessors, Accessor,
+            AccessorBounds, Sparse, SparseIndices, SparseValues, ExtensionsRequired,
+            BufferExtensions, BufferMeshopt, BufferViewExtensions, BufferViewMeshopt
+        };
+
+        // 必需字段是否出现过（Frame::seen的位）
+        enum : uint32_t {
+            kAsset = 1 << 0, kVersion = 1 << 1, kPrimitives = 1 << 2, kAttributes = 1 << 3, kMatrix = 1 << 4,
+            kBuffer = 1 << 5, kByteLength = 1 << 6, kComponentType = 1 << 7, kCount = 1 << 8, kType = 1 << 9,
+            kIndices = 1 << 10, kValues = 1 << 11, kBufferView = 1 << 12, kByteStride = 1 << 13, kMode = 1 << 14,
+        };
+
+        struct Frame {
+            Context context;
+            uint32_t seen = 0;          // NodeFloats：已读的元素个数
+            uint32_t size = 0;          // NodeFloats：应有的元素个数
+            float* floats = nullptr;    // NodeFloats：写入的位置
+            const char* name = nullptr; // NodeFloats：报错时的字段名
+            std::vector<float>* values = nullptr;   // AccessorBounds：写入的位置
+        };
+
+        Asset& asset;
+        std::vector<Frame> stack;
+        std::string currentKey;
+        bool boolValue = false;
+        double numberValue = 0;
+        std::string* stringValue = nullptr;
+
+        void _push(Context context) {
+            Frame frame;
+            frame.context = context;
+            stack.push_back(frame);
         }
-
-        if (asset.scene == -1) {
-            asset.scene = 0;
+        void _skip(Value v) {
+            if (v == Value::Object || v == Value::Array) {
+                _push(Context::Skip);
+            }
         }
-
-        asset.scenes.resize(scenes.size());
-        for (uint32_t i = 0; i < scenes.size(); ++i) {
-            // name
-            if (scenes[i].find("name") != scenes[i].end()) {
-                if (!scenes[i]["name"].is_string()) {
-                    throw MisformattedExceptionNotString("scenes[i][name]");
-                }
-
-                std::string n = scenes[i]["name"];
-                asset.scenes[i].name = n ;
+        double _number(Value v, const char* name) {
+            if (v != Value::Number) {
+                throw MisformattedExceptionNotNumber(name);
             }
-
-            // nodes
-            if (scenes[i].find("nodes") != scenes[i].end()) {
-                auto& nodes = scenes[i]["nodes"];
-                if (!nodes.is_array()) {
-                    throw MisformattedExceptionNotArray("scenes[i][nodes]");
-                }
-
-                asset.scenes[i].nodes.resize(nodes.size());
-                for (uint32_t j = 0; j < nodes.size(); ++j) {
-                    asset.scenes[i].nodes[j] = nodes[j].get<uint32_t>();
-                }
+            return numberValue;
+        }
+        std::string _string(Value v, const char* name) {
+            if (v != Value::String) {
+                throw MisformattedExceptionNotString(name);
             }
+            return std::move(*stringValue);
         }
-    }
-
-    // Meshes: 主要由primitives构成
-    // primitives 包含attribute(几何数据)、indices(索引)、material(材质)等信息
-    static void loadMeshes(Asset& asset, nlohmann::json& json){
-
-        if (json.find("meshes") == json.end()) {
-            return;
+        void _array(Value v, const char* name, Context context) {
+            if (v != Value::Array) {
+                throw MisformattedExceptionNotArray(name);
+            }
+            _push(context);
         }
-
-        auto& meshes = json["meshes"];
-
-        if (!meshes.is_array()) {
-            throw MisformattedExceptionNotArray("meshes");
+        void _object(Value v, const char* name, Context context) {
+            if (v != Value::Object) {
+                throw MisformattedExceptionNotObject(name);
+            }
+            _push(context);
+        }
+        // 定长float数组（matrix、translation、rotation、scale）
+        void _floats(Value v, const char* name, float* floats, uint32_t size) {
+            _array(v, name, Context::NodeFloats);
+            stack.back().floats = floats;
+            stack.back().size = size;
+            stack.back().name = name;
         }
 
-        asset.meshes.resize(meshes.size());
-        for (uint32_t i = 0; i < meshes.size(); ++i) {
-            // name
-            if (meshes[i].find("name") != meshes[i].end()) {
-                if (!meshes[i]["name"].is_string()) {
-                    throw MisformattedExceptionNotString("meshes[i][name]");
+        void _value(Value v) {
+            if (stack.empty()) {
+                if (v != Value::Object) {
+                    throw MisformattedExceptionNotObject("root");
                 }
-
-                std::string n = meshes[i]["name"];
-                asset.meshes[i].name = n;
-            }
-
-
-            if (meshes[i].find("primitives") == meshes[i].end()) {
-                throw MisformattedExceptionIsRequired("meshes[i][primitives]");
+                _push(Context::Root);
+                return;
             }
-
-            auto& primitives = meshes[i]["primitives"];
-            if (!primitives.is_array()) {
-                throw MisformattedExceptionNotArray("meshes[i][primitives]");
-            }
-
-            asset.meshes[i].primitives.resize(primitives.size());
-            // 每个primitive 包含attribute(几何数据)、indices(索引)、material(材质)等信息
-            // 值都是 accessor 的索引 
-            for (uint32_t j = 0; j < primitives.size(); ++j) {
-                // indices
-                if (primitives[j].find("indices") != primitives[j].end()) {
-                    if (!primitives[j]["indices"].is_number()) {
-                        throw MisformattedExceptionNotNumber("meshes[i][primitives][j][indices]");
+            Frame& frame = stack.back();
+            const std::string& key = currentKey;
+            switch (frame.context) {
+                case Context::Skip:
+                    _skip(v);
+                    break;
+
+                case Context::Root:
+                    if (key == "asset") {
+                        frame.seen |= kAsset;
+                        _object(v, "asset", Context::Asset);
+                    } else if (key == "scene") {
+                        asset.scene = (int32_t)_number(v, "scene");
+                    } else if (key == "scenes") {
+                        _array(v, "scenes", Context::Scenes);
+                        if (asset.scene == -1) {
+                            asset.scene = 0;
+                        }
+                    } else if (key == "meshes") {
+                        _array(v, "meshes", Context::Meshes);
+                    } else if (key == "nodes") {
+                        _array(v, "nodes", Context::Nodes);
+                    } else if (key == "buffers") {
+                        _array(v, "buffers", Context::Buffers);
+                    } else if (key == "bufferViews") {
+                        _array(v, "bufferViews", Context::BufferViews);
+                    } else if (key == "accessors") {
+                        _array(v, "accessors", Context::Accessors);
+                    } else if (key == "extensionsRequired") {
+                        _array(v, "extensionsRequired", Context::ExtensionsRequired);
+                    } else {
+                        _skip(v);
                     }
-
-                    asset.meshes[i].primitives[j].indices = primitives[j]["indices"].get<int32_t>();
+                    break;
+
+                // 必须支持的扩展：量化的顶点属性由AccessorView按componentType解码，
+                // meshopt压缩的bufferView在读取accessor之前解码
+                case Context::ExtensionsRequired: {
+                    std::string extension = _string(v, "extensionsRequired[i]");
+                    if (extension != "KHR_mesh_quantization" && extension != "EXT_meshopt_compression") {
+                        throw MisformattedException("extensionsRequired", "contains the unsupported extension '" + extension + "'");
+                    }
+                    break;
                 }
 
-                // material
-                if (primitives[j].find("material") != primitives[j].end()) {
-                    if (!primitives[j]["material"].is_number()) {
-                        throw MisformattedExceptionNotNumber("meshes[i][primitives][j][material]");
+                // 加载 metadata （version、copyright、generator）
+                case Context::Asset:
+                    if (key == "version") {
+                        frame.seen |= kVersion;
+                        asset.metadata.version = _string(v, "version");
+                    } else if (key == "copyright") {
+                        asset.metadata.copyright = _string(v, "copyright");
+                    } else if (key == "generator") {
+                        asset.metadata.generator = _string(v, "generator");
+                    } else {
+                        _skip(v);
                     }
-
-                    asset.meshes[i].primitives[j].material = primitives[j]["material"].get<int32_t>();
+                    break;
+
+                // scenes （通常只包含一个场景，由nodes数组组成）
+                case Context::Scenes:
+                    _object(v, "scenes[i]", Context::Scene);
+                    asset.scenes.emplace_back();
+                    break;
+                case Context::Scene:
+                    if (key == "name") {
+                        asset.scenes.back().name = _string(v, "scenes[i][name]");
+                    } else if (key == "nodes") {
+                        _array(v, "scenes[i][nodes]", Context::SceneNodes);
+                        asset.scenes.back().nodes.clear();
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                case Context::SceneNodes:
+                    asset.scenes.back().nodes.push_back((uint32_t)_number(v, "scenes[i][nodes][j]"));
+                    break;
+
+                // Meshes: 主要由primitives构成
+                // primitives 包含attribute(几何数据)、indices(索引)、material(材质)等信息，值都是 accessor 的索引
+                case Context::Meshes:
+                    _object(v, "meshes[i]", Context::Mesh);
+                    asset.meshes.emplace_back();
+                    break;
+                case Context::Mesh:
+                    if (key == "name") {
+                        asset.meshes.back().name = _string(v, "meshes[i][name]");
+                    } else if (key == "primitives") {
+                        frame.seen |= kPrimitives;
+                        _array(v, "meshes[i][primitives]", Context::Primitives);
+                        asset.meshes.back().primitives.clear();
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                case Context::Primitives:
+                    _object(v, "meshes[i][primitives][j]", Context::Primitive);
+                    asset.meshes.back().primitives.emplace_back();
+                    break;
+                case Context::Primitive: {
+                    Primitive& primitive = asset.meshes.back().primitives.back();
+                    if (key == "indices") {
+                        primitive.indices = (int32_t)_number(v, "meshes[i][primitives][j][indices]");
+                    } else if (key == "material") {
+                        primitive.material = (int32_t)_number(v, "meshes[i][primitives][j][material]");
+                    } else if (key == "mode") {
+                        primitive.mode = static_cast<Primitive::Mode>((uint8_t)_number(v, "meshes[i][primitives][j][mode]"));
+                    } else if (key == "attributes") {
+                        frame.seen |= kAttributes;
+                        _object(v, "meshes[i][primitives][j][attributes]", Context::Attributes);
+                    } else {
+                        _skip(v);
+                    }
+                    break;
                 }
-
-                // mode
-                if (primitives[j].find("mode") != primitives[j].end()) {
-                    if (!primitives[j]["mode"].is_number()) {
-                        throw MisformattedExceptionNotNumber("meshes[i][primitives][j][mode]");
+                case Context::Attributes:
+                    asset.meshes.back().primitives.back().attributes[key] =
+                        (uint32_t)_number(v, "meshes[i][primitives][j][attributes]");
+                    break;
+
+                // nodes: 每个node由matrix(或T、R、S)、mesh(meshes的索引)、children、name组成
+                case Context::Nodes:
+                    _object(v, "nodes[i]", Context::Node);
+                    asset.nodes.emplace_back();
+                    break;
+                case Context::Node: {
+                    Node& node = asset.nodes.back();
+                    if (key == "name") {
+                        node.name = _string(v, "nodes[i][name]");
+                    } else if (key == "children") {
+                        _array(v, "nodes[i][chidren]", Context::NodeChildren);
+                        node.children.clear();
+                    } else if (key == "skin") {
+                        node.skin = (int32_t)_number(v, "nodes[i][skin]");
+                    } else if (key == "mesh") {
+                        node.mesh = (int32_t)_number(v, "nodes[i][mesh]");
+                    } else if (key == "matrix") {
+                        frame.seen |= kMatrix;
+                        _floats(v, "nodes[i][matrix]", node.matrix, 16);
+                    } else if (key == "translation") {
+                        _floats(v, "nodes[i][translation]", node.translation, 3);
+                    } else if (key == "rotation") {
+                        _floats(v, "nodes[i][rotation]", node.rotation, 4);
+                    } else if (key == "scale") {
+                        _floats(v, "nodes[i][scale]", node.scale, 3);
+                    } else {
+                        // TODO: nodes[i]["camera"]、nodes[i]["weights"]
+                        _skip(v);
                     }
-
-                    asset.meshes[i].primitives[j].mode = static_cast<Primitive::Mode>(primitives[j]["mode"].get<uint8_t>());
+                    break;
                 }
-
-                if (primitives[j].find("attributes") == primitives[j].end()) {
-                    throw MisformattedExceptionIsRequired("meshes[i][primitives][j][attributes]");
+                case Context::NodeChildren:
+                    asset.nodes.back().children.push_back((int)_number(v, "nodes[i][children][j]"));
+                    break;
+                case Context::NodeFloats:
+                    if (v != Value::Number) {
+                        throw MisformattedExceptionNotNumber(std::string(frame.name) + "[j]");
+                    }
+                    if (frame.seen < frame.size) {
+                        frame.floats[frame.seen] = (float)numberValue;
+                    }
+                    ++frame.seen;
+                    break;
+
+                case Context::Buffers:
+                    _object(v, "buffers[i]", Context::Buffer);
+                    asset.buffers.emplace_back();
+                    break;
+                case Context::Buffer: {
+                    Buffer& buffer = asset.buffers.back();
+                    if (key == "name") {
+                        buffer.name = _string(v, "buffers[i][name]");
+                    } else if (key == "byteLength") {
+                        frame.seen |= kByteLength;
+                        buffer.byteLength = (uint64_t)_number(v, "buffers[i][byteLength]");
+                    } else if (key == "uri") {
+                        buffer.uri = _string(v, "buffers[i][uri]");
+                    } else if (key == "extensions") {
+                        _object(v, "buffers[i][extensions]", Context::BufferExtensions);
+                    } else {
+                        _skip(v);
+                    }
+                    break;
                 }
-
-                auto& attributes = primitives[j]["attributes"];
-                if (!attributes.is_object()) {
-                    throw MisformattedExceptionNotObject("meshes[i][primitives][j][attributes]");
+                case Context::BufferExtensions:
+                    if (key == "EXT_meshopt_compression") {
+                        _object(v, "buffers[i][extensions][EXT_meshopt_compression]", Context::BufferMeshopt);
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                case Context::BufferMeshopt:
+                    if (key == "fallback") {
+                        if (v != Value::Boolean) {
+                            throw MisformattedExceptionNotBoolean("buffers[i][extensions][EXT_meshopt_compression][fallback]");
+                        }
+                        asset.buffers.back().fallback = boolValue;
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+
+                // bufferview: 描述buffers中的数据（从哪到哪是顶点or索引）
+                case Context::BufferViews:
+                    _object(v, "bufferViews[i]", Context::BufferView);
+                    asset.bufferViews.emplace_back();
+                    break;
+                case Context::BufferView: {
+                    BufferView& bufferView = asset.bufferViews.back();
+                    if (key == "name") {
+                        bufferView.name = _string(v, "bufferViews[i][name]");
+                    } else if (key == "buffer") {
+                        frame.seen |= kBuffer;
+                        bufferView.buffer = (int32_t)_number(v, "bufferViews[i][buffer]");
+                    } else if (key == "byteOffset") {
+                        bufferView.byteOffset = (uint64_t)_number(v, "bufferViews[i][byteOffset]");
+                    } else if (key == "byteLength") {
+                        frame.seen |= kByteLength;
+                        bufferView.byteLength = (uint64_t)_number(v, "bufferViews[i][byteLength]");
+                    } else if (key == "byteStride") {
+                        bufferView.byteStride = (int32_t)_number(v, "bufferViews[i][byteStride]");
+                    } else if (key == "target") {
+                        bufferView.target = (uint16_t)_number(v, "bufferViews[i][target]");
+                    } else if (key == "extensions") {
+                        _object(v, "bufferViews[i][extensions]", Context::BufferViewExtensions);
+                    } else {
+                        // TODO: bufferViews[i]["extras"]
+                        _skip(v);
+                    }
+                    break;
+                }
+                case Context::BufferViewExtensions:
+                    if (key == "EXT_meshopt_compression") {
+                        _object(v, "bufferViews[i][extensions][EXT_meshopt_compression]", Context::BufferViewMeshopt);
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                case Context::BufferViewMeshopt: {
+                    BufferView::Meshopt& meshopt = asset.bufferViews.back().meshopt;
+                    if (key == "buffer") {
+                        frame.seen |= kBuffer;
+                        meshopt.buffer = (uint32_t)_number(v, "bufferViews[i][extensions][EXT_meshopt_compression][buffer]");
+                    } else if (key == "byteOffset") {
+                        meshopt.byteOffset = (uint64_t)_number(v, "bufferViews[i][extensions][EXT_meshopt_compression][byteOffset]");
+                    } else if (key == "byteLength") {
+                        frame.seen |= kByteLength;
+                        meshopt.byteLength = (uint64_t)_number(v, "bufferViews[i][extensions][EXT_meshopt_compression][byteLength]");
+                    } else if (key == "byteStride") {
+                        frame.seen |= kByteStride;
+                        meshopt.byteStride = (uint32_t)_number(v, "bufferViews[i][extensions][EXT_meshopt_compression][byteStride]");
+                    } else if (key == "count") {
+                        frame.seen |= kCount;
+                        meshopt.count = (uint32_t)_number(v, "bufferViews[i][extensions][EXT_meshopt_compression][count]");
+                    } else if (key == "mode") {
+                        frame.seen |= kMode;
+                        meshopt.mode = _meshoptMode(_string(v, "bufferViews[i][extensions][EXT_meshopt_compression][mode]"));
+                    } else if (key == "filter") {
+                        meshopt.filter = _meshoptFilter(_string(v, "bufferViews[i][extensions][EXT_meshopt_compression][filter]"));
+                    } else {
+                        _skip(v);
+                    }
+                    break;
                 }
 
-                for (nlohmann::json::iterator it = attributes.begin(); it != attributes.end(); ++it) {
-                    asset.meshes[i].primitives[j].attributes[it.key()] = it.value();
+                case Context::Accessors:
+                    _object(v, "accessors[i]", Context::Accessor);
+                    asset.accessors.emplace_back();
+                    break;
+                case Context::Accessor: {
+                    Accessor& accessor = asset.accessors.back();
+                    if (key == "bufferView") {
+                        accessor.bufferView = (int32_t)_number(v, "accessors[i][bufferView]");
+                    } else if (key == "byteOffset") {
+                        accessor.byteOffset = (uint32_t)_number(v, "accessors[i][byteOffset]");
+                    } else if (key == "componentType") {
+                        frame.seen |= kComponentType;
+                        accessor.componentType = (uint16_t)_number(v, "accessors[i][componentType]");
+                    } else if (key == "normalized") {
+                        if (v != Value::Boolean) {
+                            throw MisformattedExceptionNotBoolean("accessors[i][normalized]");
+                        }
+                        accessor.normalized = boolValue;
+                    } else if (key == "count") {
+                        frame.seen |= kCount;
+                        accessor.count = (uint32_t)_number(v, "accessors[i][count]");
+                    } else if (key == "type") {
+                        frame.seen |= kType;
+                        accessor.type = _accessorType(_string(v, "accessors[i][type]"));
+                    } else if (key == "min") {
+                        _array(v, "accessors[i][min]", Context::AccessorBounds);
+                        stack.back().values = &accessor.min;
+                        stack.back().name = "accessors[i][min]";
+                        accessor.min.clear();
+                    } else if (key == "max") {
+                        _array(v, "accessors[i][max]", Context::AccessorBounds);
+                        stack.back().values = &accessor.max;
+                        stack.back().name = "accessors[i][max]";
+                        accessor.max.clear();
+                    } else if (key == "sparse") {
+                        _object(v, "accessors[i][sparse]", Context::Sparse);
+                    } else {
+                        // TODO: accessors[i]["extensions"]
+                        _skip(v);
+                    }
+                    break;
+                }
+                case Context::AccessorBounds:
+                    if (v != Value::Number) {
+                        throw MisformattedExceptionNotNumber(std::string(frame.name) + "[j]");
+                    }
+                    frame.values->push_back((float)numberValue);
+                    break;
+                case Context::Sparse: {
+                    Accessor::Sparse& sparse = asset.accessors.back().sparse;
+                    if (key == "count") {
+                        frame.seen |= kCount;
+                        sparse.count = (uint32_t)_number(v, "accessors[i][sparse][count]");
+                    } else if (key == "indices") {
+                        frame.seen |= kIndices;
+                        _object(v, "accessors[i][sparse][indices]", Context::SparseIndices);
+                    } else if (key == "values") {
+                        frame.seen |= kValues;
+                        _object(v, "accessors[i][sparse][values]", Context::SparseValues);
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                }
+                case Context::SparseIndices: {
+                    auto& indices = asset.accessors.back().sparse.indices;
+                    if (key == "bufferView") {
+                        frame.seen |= kBufferView;
+                        indices.bufferView = (int32_t)_number(v, "accessors[i][sparse][indices][bufferView]");
+                    } else if (key == "byteOffset") {
+                        indices.byteOffset = (uint32_t)_number(v, "accessors[i][sparse][indices][byteOffset]");
+                    } else if (key == "componentType") {
+                        frame.seen |= kComponentType;
+                        indices.componentType = (uint32_t)_number(v, "accessors[i][sparse][indices][componentType]");
+                    } else {
+                        _skip(v);
+                    }
+                    break;
+                }
+                case Context::SparseValues: {
+                    auto& values = asset.accessors.back().sparse.values;
+                    if (key == "bufferView") {
+                        frame.seen |= kBufferView;
+                        values.bufferView = (int32_t)_number(v, "accessors[i][sparse][values][bufferView]");
+                    } else if (key == "byteOffset") {
+                        values.byteOffset = (uint32_t)_number(v, "accessors[i][sparse][values][byteOffset]");
+                    } else {
+                        _skip(v);
+                    }
+                    break;
                 }
             }
-
         }
 
-    }
-
-    void localTransform(float T[3],float R[4],float S[3],float(&Matrix)[16]){
-        std::vector<std::vector<float>> Tra(4,std::vector<float>(4)); 
-        std::vector<std::vector<float>> Rot(4,std::vector<float>(4)); 
-        std::vector<std::vector<float>> Sca(4,std::vector<float>(4)); 
-
-        Tra[0][0]=1.0; Tra[0][1]=0.0; Tra[0][2]=0.0; Tra[0][3]=T[0];
-        Tra[1][0]=0.0; Tra[1][1]=1.0; Tra[1][2]=0.0; Tra[1][3]=T[1];
-        Tra[2][0]=0.0; Tra[2][1]=0.0; Tra[2][2]=1.0; Tra[2][3]=T[2];
-        Tra[3][0]=0.0; Tra[3][1]=0.0; Tra[3][2]=0.0; Tra[3][3]=1.0;
-
-        // Rot[0][0]=1-2*R[2]*R[2]-2*R[3]*R[3]; Rot[0][1]=2*R[1]*R[2]+2*R[0]*R[3];   Rot[0][2]=2*R[1]*R[3]-2*R[0]*R[2];   Rot[0][3]=0.0;
-        // Rot[1][0]=2*R[1]*R[2]-2*R[0]*R[3];   Rot[1][1]=1-2*R[1]*R[1]-2*R[3]*R[3]; Rot[1][2]=2*R[2]*R[3]+2*R[0]*R[1];   Rot[1][3]=0.0;
-        // Rot[2][0]=2*R[1]*R[3]+2*R[0]*R[2];   Rot[2][1]=2*R[2]*R[3]-2*R[0]*R[1];   Rot[2][2]=1-2*R[1]*R[1]-2*R[2]*R[2]; Rot[2][3]=0.0;
-        // Rot[3][0]=0.0;                       Rot[3][1]=0.0;                       Rot[3][2]=0.0;                       Rot[3][3]=1.0;
-        // Rot[0][0]=R[0]*R[0]+R[1]*R[1]-R[2]*R[2]-R[3]*R[3]; Rot[0][1]=2*R[1]*R[2]+2*R[0]*R[3];   Rot[0][2]=2*R[1]*R[3]-2*R[0]*R[2];   Rot[0][3]=0.0;
-        // Rot[1][0]=2*R[1]*R[2]-2*R[0]*R[3];   Rot[1][1]=R[0]*R[0]-R[1]*R[1]+R[2]*R[2]-R[3]*R[3]; Rot[1][2]=2*R[2]*R[3]+2*R[0]*R[1];   Rot[1][3]=0.0;
-        // Rot[2][0]=2*R[1]*R[3]+2*R[0]*R[2];   Rot[2][1]=2*R[2]*R[3]-2*R[0]*R[1];   Rot[2][2]=R[0]*R[0]-R[1]*R[1]-R[2]*R[2]+R[3]*R[3]; Rot[2][3]=0.0;
-        // Rot[3][0]=0.0;                       Rot[3][1]=0.0;                       Rot[3][2]=0.0;                       Rot[3][3]=1.0;
-
-
-        // Rot[0][0]=1-2*R[2]*R[2]-2*R[3]*R[3]; Rot[1][0]=2*R[1]*R[2]+2*R[0]*R[3];   Rot[2][0]=2*R[1]*R[3]-2*R[0]*R[2];   Rot[3][0]=0.0;
-        // Rot[0][1]=2*R[1]*R[2]-2*R[0]*R[3];   Rot[1][1]=1-2*R[1]*R[1]-2*R[3]*R[3]; Rot[2][1]=2*R[2]*R[3]+2*R[0]*R[1];   Rot[3][1]=0.0;
-        // Rot[0][2]=2*R[1]*R[3]+2*R[0]*R[2];   Rot[1][2]=2*R[2]*R[3]-2*R[0]*R[1];   Rot[2][2]=1-2*R[1]*R[1]-2*R[2]*R[2]; Rot[3][2]=0.0;
-        // Rot[0][3]=0.0;                       Rot[1][3]=0.0;                       Rot[2][3]=0.0;                       Rot[3][3]=1.0;
-        // Rot[0][0]=1.0;   Rot[1][0]=0.0;   Rot[2][0]=0.0;   Rot[3][0]=0.0;
-        // Rot[0][1]=0.0;   Rot[1][1]=0.0;   Rot[2][1]=1.0;   Rot[3][1]=0.0;
-        // Rot[0][2]=0.0;   Rot[1][2]=-1.0;   Rot[2][2]=0.0;   Rot[3][2]=0.0;
-        // Rot[0][3]=0.0;   Rot[1][3]=0.0;   Rot[2][3]=0.0;   Rot[3][3]=1.0;
-
-        //  new 0119 
-        // Rot[0][0]=1-2*R[1]*R[1]-2*R[2]*R[2]; Rot[0][1]=2*R[0]*R[1]+2*R[3]*R[2];   Rot[0][2]=2*R[0]*R[2]-2*R[3]*R[1];   Rot[0][3]=0.0;
-        // Rot[1][0]=2*R[0]*R[1]-2*R[3]*R[2];   Rot[1][1]=1-2*R[0]*R[0]-2*R[2]*R[2]; Rot[1][2]=2*R[1]*R[2]+2*R[3]*R[0];   Rot[1][3]=0.0;
-        // Rot[2][0]=2*R[0]*R[2]+2*R[3]*R[1];   Rot[2][1]=2*R[1]*R[2]-2*R[3]*R[0];   Rot[2][2]=1-2*R[0]*R[0]-2*R[1]*R[1]; Rot[2][3]=0.0;
-        // Rot[3][0]=0.0;                       Rot[3][1]=0.0;                       Rot[3][2]=0.0;                       Rot[3][3]=1.0;
-
-        Rot[0][0]=1-2*R[1]*R[1]-2*R[2]*R[2]; Rot[1][0]=2*R[0]*R[1]+2*R[3]*R[2];   Rot[2][0]=2*R[0]*R[2]-2*R[3]*R[1];   Rot[3][0]=0.0;
-        Rot[0][1]=2*R[0]*R[1]-2*R[3]*R[2];   Rot[1][1]=1-2*R[0]*R[0]-2*R[2]*R[2]; Rot[2][1]=2*R[1]*R[2]+2*R[3]*R[0];   Rot[3][1]=0.0;
-        Rot[0][2]=2*R[0]*R[2]+2*R[3]*R[1];   Rot[1][2]=2*R[1]*R[2]-2*R[3]*R[0];   Rot[2][2]=1-2*R[0]*R[0]-2*R[1]*R[1]; Rot[3][2]=0.0;
-        Rot[0][3]=0.0;                       Rot[1][3]=0.0;                       Rot[2][3]=0.0;                       Rot[3][3]=1.0;
-
-        // Rot[0][0]=0.875;   Rot[1][0]=-0.21651;   Rot[2][0]=0.43301;   Rot[3][0]=0.0;
-        // Rot[0][1]=0.43301;   Rot[1][1]=0.75;   Rot[2][1]=-0.5;   Rot[3][1]=0.0;
-        // Rot[0][2]=-0.21651;   Rot[1][2]=0.625;   Rot[2][2]=0.75;   Rot[3][2]=0.0;
-        // Rot[0][3]=0.0;   Rot[1][3]=0.0;   Rot[2][3]=0.0;   Rot[3][3]=1.0;
-
-
-        std::cout<<"\nRot Test\n";
-        for(int i=0;i<4;i++){
-            for(int j=0;j<4;j++){
-                std::cout<<Rot[i][j]<<" ";
-            }
-            std::cout<<"\n";
-        }
-
-
-        Sca[0][0]=S[0]; Sca[0][1]=0.0;  Sca[0][2]=0.0;  Sca[0][3]=0.0;
-        Sca[1][0]=0.0;  Sca[1][1]=S[1]; Sca[1][2]=0.0;  Sca[1][3]=0.0;
-        Sca[2][0]=0.0;  Sca[2][1]=0.0;  Sca[2][2]=S[2]; Sca[2][3]=0.0;
-        Sca[3][0]=0.0;  Sca[3][1]=0.0;  Sca[3][2]=0.0;  Sca[3][3]=1.0;
-
-        // tmp = T*R
-        std::vector<std::vector<float>> tmp(4,std::vector<float>(4)); 
-        tmp[0][0]=Tra[0][0]*Rot[0][0] + Tra[0][1]*Rot[1][0] + Tra[0][2]*Rot[2][0] + Tra[0][3]*Rot[3][0];  tmp[0][1]=Tra[0][0]*Rot[0][1] + Tra[0][1]*Rot[1][1] + Tra[0][2]*Rot[2][1] + Tra[0][3]*Rot[3][1];  
-        tmp[0][2]=Tra[0][0]*Rot[0][2] + Tra[0][1]*Rot[1][2] + Tra[0][2]*Rot[2][2] + Tra[0][3]*Rot[3][2];  tmp[0][3]=Tra[0][0]*Rot[0][3] + Tra[0][1]*Rot[1][3] + Tra[0][2]*Rot[2][3] + Tra[0][3]*Rot[3][3];
-        tmp[1][0]=Tra[1][0]*Rot[0][0] + Tra[1][1]*Rot[1][0] + Tra[1][2]*Rot[2][0] + Tra[1][3]*Rot[3][0];  tmp[1][1]=Tra[1][0]*Rot[0][1] + Tra[1][1]*Rot[1][1] + Tra[1][2]*Rot[2][1] + Tra[1][3]*Rot[3][1]; 
-        tmp[1][2]=Tra[1][0]*Rot[0][2] + Tra[1][1]*Rot[1][2] + Tra[1][2]*Rot[2][2] + Tra[1][3]*Rot[3][2];  tmp[1][3]=Tra[1][0]*Rot[0][3] + Tra[1][1]*Rot[1][3] + Tra[1][2]*Rot[2][3] + Tra[1][3]*Rot[3][3];
-        tmp[2][0]=Tra[2][0]*Rot[0][0] + Tra[2][1]*Rot[1][0] + Tra[2][2]*Rot[2][0] + Tra[2][3]*Rot[3][0];  tmp[2][1]=Tra[2][0]*Rot[0][1] + Tra[2][1]*Rot[1][1] + Tra[2][2]*Rot[2][1] + Tra[2][3]*Rot[3][1];  
-        tmp[2][2]=Tra[2][0]*Rot[0][2] + Tra[2][1]*Rot[1][2] + Tra[2][2]*Rot[2][2] + Tra[2][3]*Rot[3][2];  tmp[2][3]=Tra[2][0]*Rot[0][3] + Tra[2][1]*Rot[1][3] + Tra[2][2]*Rot[2][3] + Tra[2][3]*Rot[3][3];
-        tmp[3][0]=Tra[3][0]*Rot[0][0] + Tra[3][1]*Rot[1][0] + Tra[3][2]*Rot[2][0] + Tra[3][3]*Rot[3][0];  tmp[3][1]=Tra[3][0]*Rot[0][1] + Tra[3][1]*Rot[1][1] + Tra[3][2]*Rot[2][1] + Tra[3][3]*Rot[3][1];
-        tmp[3][2]=Tra[3][0]*Rot[0][2] + Tra[3][1]*Rot[1][2] + Tra[3][2]*Rot[2][2] + Tra[3][3]*Rot[3][2];  tmp[3][3]=Tra[3][0]*Rot[0][3] + Tra[3][1]*Rot[1][3] + Tra[3][2]*Rot[2][3] + Tra[3][3]*Rot[3][3];
-
-        // matrix = tmp*S
-        std::vector<float>tmp2(16) ;
-        tmp2[0]=tmp[0][0]*Sca[0][0] + tmp[0][1]*Sca[1][0] + tmp[0][2]*Sca[2][0] + tmp[0][3]*Sca[3][0];   tmp2[1]=tmp[0][0]*Sca[0][1] + tmp[0][1]*Sca[1][1] + tmp[0][2]*Sca[2][1] + tmp[0][3]*Sca[3][1];  
-        tmp2[2]=tmp[0][0]*Sca[0][2] + tmp[0][1]*Sca[1][2] + tmp[0][2]*Sca[2][2] + tmp[0][3]*Sca[3][2];   tmp2[3]=tmp[0][0]*Sca[0][3] + tmp[0][1]*Sca[1][3] + tmp[0][2]*Sca[2][3] + tmp[0][3]*Sca[3][3];
-        tmp2[4]=tmp[1][0]*Sca[0][0] + tmp[1][1]*Sca[1][0] + tmp[1][2]*Sca[2][0] + tmp[1][3]*Sca[3][0];   tmp2[5]=tmp[1][0]*Sca[0][1] + tmp[1][1]*Sca[1][1] + tmp[1][2]*Sca[2][1] + tmp[1][3]*Sca[3][1]; 
-        tmp2[6]=tmp[1][0]*Sca[0][2] + tmp[1][1]*Sca[1][2] + tmp[1][2]*Sca[2][2] + tmp[1][3]*Sca[3][2];   tmp2[7]=tmp[1][0]*Sca[0][3] + tmp[1][1]*Sca[1][3] + tmp[1][2]*Sca[2][3] + tmp[1][3]*Sca[3][3];
-        tmp2[8]=tmp[2][0]*Sca[0][0] + tmp[2][1]*Sca[1][0] + tmp[2][2]*Sca[2][0] + tmp[2][3]*Sca[3][0];   tmp2[9]=tmp[2][0]*Sca[0][1] + tmp[2][1]*Sca[1][1] + tmp[2][2]*Sca[2][1] + tmp[2][3]*Sca[3][1];  
-        tmp2[10]=tmp[2][0]*Sca[0][2] + tmp[2][1]*Sca[1][2] + tmp[2][2]*Sca[2][2] + tmp[2][3]*Sca[3][2];  tmp2[11]=tmp[2][0]*Sca[0][3] + tmp[2][1]*Sca[1][3] + tmp[2][2]*Sca[2][3] + tmp[2][3]*Sca[3][3];
-        tmp2[12]=tmp[3][0]*Sca[0][0] + tmp[3][1]*Sca[1][0] + tmp[3][2]*Sca[2][0] + tmp[3][3]*Sca[3][0];  tmp2[13]=tmp[3][0]*Sca[0][1] + tmp[3][1]*Sca[1][1] + tmp[3][2]*Sca[2][1] + tmp[3][3]*Sca[3][1];
-        tmp2[14]=tmp[3][0]*Sca[0][2] + tmp[3][1]*Sca[1][2] + tmp[3][2]*Sca[2][2] + tmp[3][3]*Sca[3][2];  tmp2[15]=tmp[3][0]*Sca[0][3] + tmp[3][1]*Sca[1][3] + tmp[3][2]*Sca[2][3] + tmp[3][3]*Sca[3][3];
-
-        std::vector<float>tmp3(16) ;
-        tmp3[0] = Matrix[0]*tmp2[0] + Matrix[1]*tmp2[4] + Matrix[2]*tmp2[8] + Matrix[3]*tmp2[12];
-        tmp3[1] = Matrix[0]*tmp2[1] + Matrix[1]*tmp2[5] + Matrix[2]*tmp2[9] + Matrix[3]*tmp2[13];
-        tmp3[2] = Matrix[0]*tmp2[2] + Matrix[1]*tmp2[6] + Matrix[2]*tmp2[10] + Matrix[3]*tmp2[14];
-        tmp3[3] = Matrix[0]*tmp2[3] + Matrix[1]*tmp2[7] + Matrix[2]*tmp2[11] + Matrix[3]*tmp2[15];
-
-        tmp3[4] = Matrix[4]*tmp2[0] + Matrix[5]*tmp2[4] + Matrix[6]*tmp2[8] + Matrix[7]*tmp2[12];
-        tmp3[5] = Matrix[4]*tmp2[1] + Matrix[5]*tmp2[5] + Matrix[6]*tmp2[9] + Matrix[7]*tmp2[13];
-        tmp3[6] = Matrix[4]*tmp2[2] + Matrix[5]*tmp2[6] + Matrix[6]*tmp2[10] + Matrix[7]*tmp2[14];
-        tmp3[7] = Matrix[4]*tmp2[3] + Matrix[5]*tmp2[7] + Matrix[6]*tmp2[11] + Matrix[7]*tmp2[15];
-
-        tmp3[8] = Matrix[8]*tmp2[0] + Matrix[9]*tmp2[4] + Matrix[10]*tmp2[8] + Matrix[11]*tmp2[12];
-        tmp3[9] = Matrix[8]*tmp2[1] + Matrix[9]*tmp2[5] + Matrix[10]*tmp2[9] + Matrix[11]*tmp2[13];
-        tmp3[10] = Matrix[8]*tmp2[2] + Matrix[9]*tmp2[6] + Matrix[10]*tmp2[10] + Matrix[11]*tmp2[14];
-        tmp3[11] = Matrix[8]*tmp2[3] + Matrix[9]*tmp2[7] + Matrix[10]*tmp2[11] + Matrix[11]*tmp2[15];
-
-        tmp3[12] = Matrix[12]*tmp2[0] + Matrix[13]*tmp2[4] + Matrix[14]*tmp2[8] + Matrix[15]*tmp2[12];
-        tmp3[13] = Matrix[12]*tmp2[1] + Matrix[13]*tmp2[5] + Matrix[14]*tmp2[9] + Matrix[15]*tmp2[13];
-        tmp3[14] = Matrix[12]*tmp2[2] + Matrix[13]*tmp2[6] + Matrix[14]*tmp2[10] + Matrix[15]*tmp2[14];
-        tmp3[15] = Matrix[12]*tmp2[3] + Matrix[13]*tmp2[7] + Matrix[14]*tmp2[11] + Matrix[15]*tmp2[15];
-
-
-        for(int k=0;k<16;k++){
-            Matrix[k] = tmp3[k]; 
-        }
-
-    }
-    // 由多个children和多个mesh组成 
-    // children是下面mesh的索引，可以定位mesh
-    // 每个mesh都是由matrix(旋转缩放平移变换矩阵？)、mesh(meshes的索引)、name组成
-    // 坐标转换localTransform：需要将T、R、S转换为Matrix
-    static void loadNodes(Asset& asset, nlohmann::json& json){
-        if (json.find("nodes") == json.end()) {
-            return;
+        static Accessor::Type _accessorType(const std::string& type) {
+            if (type == "SCALAR") {
+                return Accessor::Type::Scalar;
+            } else if (type == "VEC2") {
+                return Accessor::Type::Vec2;
+            } else if (type == "VEC3") {
+                return Accessor::Type::Vec3;
+            } else if (type == "VEC4") {
+                return Accessor::Type::Vec4;
+            } else if (type == "MAT2") {
+                return Accessor::Type::Mat2;
+            } else if (type == "MAT3") {
+                return Accessor::Type::Mat3;
+            } else if (type == "MAT4") {
+                return Accessor::Type::Mat4;
+            }
+            throw MisformattedException("accessors[i][type]", "is not a valid type");
         }
 
-        auto& nodes = json["nodes"];
-        if (!nodes.is_array()) {
-            throw MisformattedExceptionNotArray("nodes");
+        static BufferView::Meshopt::Mode _meshoptMode(const std::string& mode) {
+            if (mode == "ATTRIBUTES") {
+                return BufferView::Meshopt::Mode::Attributes;
+            } else if (mode == "TRIANGLES") {
+                return BufferView::Meshopt::Mode::Triangles;
+            } else if (mode == "INDICES") {
+                return BufferView::Meshopt::Mode::Indices;
+            }
+            throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][mode]", "is not a valid mode");
         }
-       
-        asset.nodes.resize(nodes.size());
-        for (uint32_t i = 0; i < nodes.size(); i++) {
-            // name
-            if (nodes[i].find("name") != nodes[i].end()) {
-                if (!nodes[i]["name"].is_string()) {
-                    throw MisformattedExceptionNotString("nodes[i][name]");
-                }
 
-                std::string n = nodes[i]["name"];
-                asset.nodes[i].name = n;
+        static BufferView::Meshopt::Filter _meshoptFilter(const std::string& filter) {
+            if (filter == "NONE") {
+                return BufferView::Meshopt::Filter::None;
+            } else if (filter == "OCTAHEDRAL") {
+                return BufferView::Meshopt::Filter::Octahedral;
+            } else if (filter == "QUATERNION") {
+                return BufferView::Meshopt::Filter::Quaternion;
+            } else if (filter == "EXPONENTIAL") {
+                return BufferView::Meshopt::Filter::Exponential;
             }
+            throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][filter]", "is not a valid filter");
+        }
 
-            // camera
-            // if (nodes[i].find("camera") != nodes[i].end()) {
-            //     if (!nodes[i]["camera"].is_number()) {
-            //         throw MisformattedExceptionNotNumber("nodes[i][camera]");
-            //     }
-
-            //     asset.nodes[i].camera = nodes[i]["camera"].get<int32_t>();
-            // }
-
-            // children
-            std::cout<<"children";
-            if (nodes[i].find("children") != nodes[i].end()) {
-                auto& children = nodes[i]["children"];
-                if (!children.is_array()) {
-                    throw MisformattedExceptionNotArray("nodes[i][chidren]");
-                }
-
-                asset.nodes[i].children.resize(children.size());
-                for (uint32_t j = 0; j < children.size(); ++j) {
-                    asset.nodes[i].children[j] = children[j].get<uint32_t>();
+        // 对象/数组结束：检查必需字段
+        void _close() {
+            const Frame& frame = stack.back();
+            switch (frame.context) {
+                case Context::Root:
+                    if (!(frame.seen & kAsset)) {
+                        throw MisformattedExceptionIsRequired("asset");
+                    }
+                    break;
+                case Context::Asset:
+                    if (!(frame.seen & kVersion)) {
+                        throw MisformattedExceptionIsRequired("asset[version]");
+                    }
+                    break;
+                case Context::Mesh:
+                    if (!(frame.seen & kPrimitives)) {
+                        throw MisformattedExceptionIsRequired("meshes[i][primitives]");
+                    }
+                    break;
+                case Context::Primitive:
+                    if (!(frame.seen & kAttributes)) {
+                        throw MisformattedExceptionIsRequired("meshes[i][primitives][j][attributes]");
+                    }
+                    break;
+                case Context::Node: {
+                    // 没有matrix时由T、R、S算出局部变换
+                    Node& node = asset.nodes.back();
+                    if (!(frame.seen & kMatrix)) {
+                        localTransform(node.translation, node.rotation, node.scale, node.matrix);  // T * R * S
+                    }
+                    break;
                 }
-            }
-
-            // skin
-            if (nodes[i].find("skin") != nodes[i].end()) {
-                if (!nodes[i]["skin"].is_number()) {
-                    throw MisformattedExceptionNotNumber("nodes[i][skin]");
+                case Context::NodeFloats:
+                    if (frame.seen != frame.size) {
+                        throw MisformattedExceptionNotGoodSizeArray(frame.name);
+                    }
+                    break;
+                case Context::Buffer:
+                    if (!(frame.seen & kByteLength)) {
+                        throw MisformattedExceptionIsRequired("buffers[i][byteLength]");
+                    }
+                    break;
+                case Context::BufferView:
+                    if (!(frame.seen & kBuffer)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][buffer]");
+                    }
+                    if (!(frame.seen & kByteLength)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][byteLength]");
+                    }
+                    break;
+                case Context::Accessor: {
+                    if (!(frame.seen & kComponentType)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][componentType]");
+                    }
+                    if (!(frame.seen & kCount)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][count]");
+                    }
+                    if (!(frame.seen & kType)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][type]");
+                    }
+                    // min/max可能出现在type之前，读完整个accessor再检查长度
+                    const Accessor& accessor = asset.accessors.back();
+                    const size_t components = componentCount(accessor.type);
+                    if (!accessor.min.empty() && accessor.min.size() != components) {
+                        throw MisformattedExceptionNotGoodSizeArray("accessors[i][min]");
+                    }
+                    if (!accessor.max.empty() && accessor.max.size() != components) {
+                        throw MisformattedExceptionNotGoodSizeArray("accessors[i][max]");
+                    }
+                    break;
                 }
-
-                asset.nodes[i].skin = nodes[i]["skin"].get<int32_t>();
+                case Context::BufferViewMeshopt:
+                    if (!(frame.seen & kBuffer)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][extensions][EXT_meshopt_compression][buffer]");
+                    }
+                    if (!(frame.seen & kByteLength)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][extensions][EXT_meshopt_compression][byteLength]");
+                    }
+                    if (!(frame.seen & kByteStride)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][extensions][EXT_meshopt_compression][byteStride]");
+                    }
+                    if (!(frame.seen & kCount)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][extensions][EXT_meshopt_compression][count]");
+                    }
+                    if (!(frame.seen & kMode)) {
+                        throw MisformattedExceptionIsRequired("bufferViews[i][extensions][EXT_meshopt_compression][mode]");
+                    }
+                    break;
+                case Context::Sparse:
+                    if (!(frame.seen & kCount)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][count]");
+                    }
+                    if (!(frame.seen & kIndices)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][indices]");
+                    }
+                    if (!(frame.seen & kValues)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][values]");
+                    }
+                    break;
+                case Context::SparseIndices:
+                    if (!(frame.seen & kBufferView)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][indices][bufferView]");
+                    }
+                    if (!(frame.seen & kComponentType)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][indices][componentType]");
+                    }
+                    break;
+                case Context::SparseValues:
+                    if (!(frame.seen & kBufferView)) {
+                        throw MisformattedExceptionIsRequired("accessors[i][sparse][values][bufferView]");
+                    }
+                    break;
+                default:
+                    break;
             }
-
-            // TODO: nodes[i]["matrix"]
-            // matrix 
-            bool hasMatrix = false ;
-            if (nodes[i].find("matrix") != nodes[i].end()) {
-                if (!nodes[i]["matrix"].is_array()) {
-                    throw MisformattedExceptionNotArray("nodes[i][matrix]");
+            stack.pop_back();
+        }
+    };
+
+    // 从根节点出发深度优先遍历场景图，父节点总是先于子节点算出worldMatrix，
+    // 每个节点只算一次。先遍历各scene的根节点，再处理不属于任何scene的孤立子树；
+    // 出现环或一个节点有多个父节点时报错
+    static void computeWorldTransforms(Asset& asset){
+        const uint32_t count = asset.nodes.size();
+        std::vector<uint8_t> hasParent(count, 0);
+        for (auto& node : asset.nodes) {
+            for (int child : node.children) {
+                if (child < 0 || (uint32_t)child >= count) {
+                    throw MisformattedException("nodes[i][children]", "is not a valid node");
                 }
-
-                if (nodes[i]["matrix"].size() != 16) {
-                    throw MisformattedExceptionNotGoodSizeArray("nodes[i][matrix]");
+                if (hasParent[child]) {
+                    throw MisformattedException("nodes[i][children]", "node has more than one parent");
                 }
-                std::vector<float> tmp (16) ;
-                std::vector<float> tmp2 (16) ;
-                for (uint32_t j = 0; j < 16; ++j) {
-                    if (!nodes[i]["matrix"][j].is_number()) {
-                        throw MisformattedExceptionNotNumber("nodes[i][matrix][j]");
-                    }
+                hasParent[child] = 1;
+            }
+        }
 
-                   // asset.nodes[i].matrix[j] = nodes[i]["matrix"][j].get<float>();
-                    tmp[j]= nodes[i]["matrix"][j].get<float>();
+        std::vector<uint32_t> roots;
+        for (auto& scene : asset.scenes) {
+            for (uint32_t root : scene.nodes) {
+                if (root >= count) {
+                    throw MisformattedException("scenes[i][nodes]", "is not a valid node");
                 }
-                tmp2[0] = tmp[0]*asset.nodes[i].matrix[0] + tmp[1]*asset.nodes[i].matrix[4] + tmp[2]*asset.nodes[i].matrix[8] + tmp[3]*asset.nodes[i].matrix[12];
-                tmp2[1] = tmp[0]*asset.nodes[i].matrix[1] + tmp[1]*asset.nodes[i].matrix[5] + tmp[2]*asset.nodes[i].matrix[9] + tmp[3]*asset.nodes[i].matrix[13];
-                tmp2[2] = tmp[0]*asset.nodes[i].matrix[2] + tmp[1]*asset.nodes[i].matrix[6] + tmp[2]*asset.nodes[i].matrix[10] + tmp[3]*asset.nodes[i].matrix[14];
-                tmp2[3] = tmp[0]*asset.nodes[i].matrix[3] + tmp[1]*asset.nodes[i].matrix[7] + tmp[2]*asset.nodes[i].matrix[11] + tmp[3]*asset.nodes[i].matrix[15];
-
-                tmp2[4] = tmp[4]*asset.nodes[i].matrix[0] + tmp[5]*asset.nodes[i].matrix[4] + tmp[6]*asset.nodes[i].matrix[8] + tmp[7]*asset.nodes[i].matrix[12];
-                tmp2[5] = tmp[4]*asset.nodes[i].matrix[1] + tmp[5]*asset.nodes[i].matrix[5] + tmp[6]*asset.nodes[i].matrix[9] + tmp[7]*asset.nodes[i].matrix[13];
-                tmp2[6] = tmp[4]*asset.nodes[i].matrix[2] + tmp[5]*asset.nodes[i].matrix[6] + tmp[6]*asset.nodes[i].matrix[10] + tmp[7]*asset.nodes[i].matrix[14];
-                tmp2[7] = tmp[4]*asset.nodes[i].matrix[3] + tmp[5]*asset.nodes[i].matrix[7] + tmp[6]*asset.nodes[i].matrix[11] + tmp[7]*asset.nodes[i].matrix[15];
-
-                tmp2[8] = tmp[8]*asset.nodes[i].matrix[0] + tmp[9]*asset.nodes[i].matrix[4] + tmp[10]*asset.nodes[i].matrix[8] + tmp[11]*asset.nodes[i].matrix[12];
-                tmp2[9] = tmp[8]*asset.nodes[i].matrix[1] + tmp[9]*asset.nodes[i].matrix[5] + tmp[10]*asset.nodes[i].matrix[9] + tmp[11]*asset.nodes[i].matrix[13];
-                tmp2[10] = tmp[8]*asset.nodes[i].matrix[2] + tmp[9]*asset.nodes[i].matrix[6] + tmp[10]*asset.nodes[i].matrix[10] + tmp[11]*asset.nodes[i].matrix[14];
-                tmp2[11] = tmp[8]*asset.nodes[i].matrix[3] + tmp[9]*asset.nodes[i].matrix[7] + tmp[10]*asset.nodes[i].matrix[11] + tmp[11]*asset.nodes[i].matrix[15];
-
-                tmp2[12] = tmp[12]*asset.nodes[i].matrix[0] + tmp[13]*asset.nodes[i].matrix[4] + tmp[14]*asset.nodes[i].matrix[8] + tmp[15]*asset.nodes[i].matrix[12];
-                tmp2[13] = tmp[12]*asset.nodes[i].matrix[1] + tmp[13]*asset.nodes[i].matrix[5] + tmp[14]*asset.nodes[i].matrix[9] + tmp[15]*asset.nodes[i].matrix[13];
-                tmp2[14] = tmp[12]*asset.nodes[i].matrix[2] + tmp[13]*asset.nodes[i].matrix[6] + tmp[14]*asset.nodes[i].matrix[10] + tmp[15]*asset.nodes[i].matrix[14];
-                tmp2[15] = tmp[12]*asset.nodes[i].matrix[3] + tmp[13]*asset.nodes[i].matrix[7] + tmp[14]*asset.nodes[i].matrix[11] + tmp[15]*asset.nodes[i].matrix[15];
-
-                for(int k=0;k<16;k++){
-                    asset.nodes[i].matrix[k] = tmp2[k]; 
+                if (hasParent[root]) {
+                    throw MisformattedException("scenes[i][nodes]", "is not a root node");
                 }
-
-                hasMatrix = true ;
+                roots.push_back(root);
             }
-            // mesh
-            if (nodes[i].find("mesh") != nodes[i].end()) {
-                if (!nodes[i]["mesh"].is_number()) {
-                    throw MisformattedExceptionNotNumber("nodes[i][mesh]");
-                }
-
-                asset.nodes[i].mesh = nodes[i]["mesh"].get<int32_t>();
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!hasParent[i]) {
+                roots.push_back(i);
             }
-            // translation
-            if (nodes[i].find("translation") != nodes[i].end()) {
-                if (!nodes[i]["translation"].is_array()) {
-                    throw MisformattedExceptionNotArray("nodes[i][translation]");
-                }
-
-                if (nodes[i]["translation"].size() != 3) {
-                    throw MisformattedExceptionNotGoodSizeArray("nodes[i][translation]");
-                }
-
-                for (uint32_t j = 0; j < 3; ++j) {
-                    if (!nodes[i]["translation"][j].is_number()) {
-                        throw MisformattedExceptionNotNumber("nodes[i][translation][j]");
-                    }
+        }
 
-                    asset.nodes[i].translation[j] = nodes[i]["translation"][j].get<float>();
-                }
+        std::vector<uint8_t> visited(count, 0);
+        std::vector<uint32_t> stack;
+        size_t reached = 0;
+        for (uint32_t root : roots) {
+            if (visited[root]) {
+                continue;
             }
-
-            // rotation
-            if (nodes[i].find("rotation") != nodes[i].end()) {
-                if (!nodes[i]["rotation"].is_array()) {
-                    throw MisformattedExceptionNotArray("nodes[i][rotation]");
-                }
-
-                if (nodes[i]["rotation"].size() != 4) {
-                    throw MisformattedExceptionNotGoodSizeArray("nodes[i][rotation]");
+            Node& node = asset.nodes[root];
+            std::copy(node.matrix, node.matrix + 16, node.worldMatrix);
+            visited[root] = 1;
+            ++reached;
+            stack.push_back(root);
+            while (!stack.empty()) {
+                const Node& parent = asset.nodes[stack.back()];
+                stack.pop_back();
+                for (int child : parent.children) {
+                    Node& node = asset.nodes[child];
+                    multiplyMatrix(parent.worldMatrix, node.matrix, node.worldMatrix);
+                    visited[child] = 1;
+                    ++reached;
+                    stack.push_back(child);
                 }
+            }
+        }
+        // 每个节点至多一个父节点，到不了的节点只能在环上
+        if (reached != count) {
+            throw MisformattedException("nodes[i][children]", "contains a cycle");
+        }
+    }
 
-                for (uint32_t j = 0; j < 4; ++j) {
-                    if (!nodes[i]["rotation"][j].is_number()) {
-                        throw MisformattedExceptionNotNumber("nodes[i][rotation][j]");
-                    }
-
-                    asset.nodes[i].rotation[j] = nodes[i]["rotation"][j].get<float>();
-                }
+    // 每个buffer是否被某个bufferView（含meshopt的压缩数据）引用
+    static std::vector<char> referencedBuffers(const Asset& asset) {
+        std::vector<char> referenced(asset.buffers.size(), 0);
+        for (const BufferView& bufferView : asset.bufferViews) {
+            if (bufferView.buffer < referenced.size()) {
+                referenced[bufferView.buffer] = 1;
             }
-            // scale
-            if (nodes[i].find("scale") != nodes[i].end()) {
-                if (!nodes[i]["scale"].is_array()) {
-                    throw MisformattedExceptionNotArray("nodes[i][scale]");
-                }
+            if (bufferView.meshopt.count && bufferView.meshopt.buffer < referenced.size()) {
+                referenced[bufferView.meshopt.buffer] = 1;
+            }
+        }
+        return referenced;
+    }
 
-                if (nodes[i]["scale"].size() != 3) {
-                    throw MisformattedExceptionNotGoodSizeArray("nodes[i][scale]");
+    // buffers的字段在解析JSON时已读入，这里取得各buffer的数据。
+    // 只读取被bufferView（含meshopt的压缩数据）引用的buffer；各buffer并行打开，
+    // 外部文件映射后立即发起异步预读，解码第一个mesh时其余buffer的I/O仍在进行
+    static void loadBuffers(Asset& asset, const BinaryChunk& bin) {
+        std::vector<char> referenced = referencedBuffers(asset);
+        ThreadPool::global().parallel_for(0, asset.buffers.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!referenced[i]) {
+                    continue;
                 }
-
-                for (uint32_t j = 0; j < 3; ++j) {
-                    if (!nodes[i]["scale"][j].is_number()) {
-                        throw MisformattedExceptionNotNumber("nodes[i][scale][j]");
+                // GLB: 没有uri的第0个buffer就是BIN块，直接指向文件映射
+                if (i == 0 && bin.data && !asset.buffers[i].uri.size()) {
+                    if (bin.byteLength < asset.buffers[i].byteLength) {
+                        throw MisformattedException("buffers[0][byteLength]", "is larger than the GLB BIN chunk");
                     }
-
-                    asset.nodes[i].scale[j] = nodes[i]["scale"][j].get<float>();
+                    asset.buffers[i].data = bin.data;
+                    asset.buffers[i].storage = bin.file;
+                    continue;
                 }
-            }
-
-            if(!hasMatrix)
-                localTransform(asset.nodes[i].translation,asset.nodes[i].rotation,asset.nodes[i].scale,asset.nodes[i].matrix) ;  // T * R * S
-            
-
-            // 20220213 add
-            for(int k=0;k<asset.nodes[i].children.size();k++){
-                std::cout<<"children ininin:"<<std::endl;
-                for(int p=0;p<16;p++){
-                    asset.nodes[asset.nodes[i].children[k]].matrix[p]=asset.nodes[i].matrix[p] ;
+                // meshopt的占位buffer不需要数据
+                if (asset.buffers[i].fallback && !asset.buffers[i].uri.size()) {
+                    continue;
                 }
-            }
 
-
-            std::cout<<"\nmatrix test:"<<std::endl;
-            for(int k=0;k<16;k+=4){
-                std::cout<<asset.nodes[i].matrix[k]<<" "<<asset.nodes[i].matrix[k+1]<<" "<<asset.nodes[i].matrix[k+2]<< " "<<asset.nodes[i].matrix[k+3]<<std::endl;
+                loadBufferData(asset, asset.buffers[i]);
             }
-
-            // TODO: nodes[i]["weights"]
-        }
-
+        });
     }
 
-    static void loadBuffers(Asset& asset, nlohmann::json& json) {
-        if (json.find("buffers") == json.end()) {
+    /**
+     * @brief 解码EXT_meshopt_compression压缩的bufferView
+     *  Every compressed bufferView gets a buffer of its own (appended to
+     *  asset.buffers) holding count * byteStride decoded bytes, and is
+     *  pointed at it, so accessors read the decoded data through the usual
+     *  AccessorView path into vV/iV.  The bufferViews are independent and
+     *  are decoded in parallel.
+     */
+    static void decodeMeshoptBufferViews(Asset& asset) {
+        std::vector<uint32_t> compressed;
+        for (uint32_t i = 0; i < asset.bufferViews.size(); ++i) {
+            if (asset.bufferViews[i].meshopt.count) {
+                compressed.push_back(i);
+            }
+        }
+        if (compressed.empty()) {
             return;
         }
 
-        auto& buffers = json["buffers"];
-        if (!buffers.is_array()) {
-            throw MisformattedExceptionNotArray("buffers");
+        // 先分配好所有解码结果的buffer（asset.buffers不能在并行解码时扩容）
+        const size_t first = asset.buffers.size();
+        asset.buffers.resize(first + compressed.size());
+        for (size_t k = 0; k < compressed.size(); ++k) {
+            const BufferView::Meshopt& meshopt = asset.bufferViews[compressed[k]].meshopt;
+            if (meshopt.buffer >= first) {
+                throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][buffer]", "is not a valid buffer");
+            }
+            const Buffer& source = asset.buffers[meshopt.buffer];
+            if (meshopt.byteOffset + meshopt.byteLength > source.byteLength || !source.data) {
+                throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression]", "does not fit in its buffer");
+            }
+            uint64_t byteLength = (uint64_t)meshopt.count * meshopt.byteStride;
+            std::shared_ptr<uint8_t[]> bytes(new uint8_t[byteLength]);
+            Buffer& decoded = asset.buffers[first + k];
+            decoded.byteLength = byteLength;
+            decoded.data = bytes.get();
+            decoded.storage = bytes;
         }
 
-        asset.buffers.resize(buffers.size());
-        for (uint32_t i = 0; i < buffers.size(); ++i) {
-
-            // name
-            if (buffers[i].find("name") != buffers[i].end()) {
-                if (!buffers[i]["name"].is_string()) {
-                    throw MisformattedExceptionNotString("buffers[i][name]");
+        ThreadPool::global().parallel_for(0, compressed.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const BufferView::Meshopt& meshopt = asset.bufferViews[compressed[k]].meshopt;
+                const uint8_t* src = asset.buffers[meshopt.buffer].data + meshopt.byteOffset;
+                uint8_t* dst = const_cast<uint8_t*>(asset.buffers[first + k].data);
+                bool ok = false;
+                switch (meshopt.mode) {
+                    case BufferView::Meshopt::Mode::Attributes:
+                        ok = decodeMeshoptVertices(dst, meshopt.count, meshopt.byteStride, src, meshopt.byteLength);
+                        break;
+                    case BufferView::Meshopt::Mode::Triangles:
+                        ok = decodeMeshoptTriangles(dst, meshopt.count, meshopt.byteStride, src, meshopt.byteLength);
+                        break;
+                    case BufferView::Meshopt::Mode::Indices:
+                        ok = decodeMeshoptIndices(dst, meshopt.count, meshopt.byteStride, src, meshopt.byteLength);
+                        break;
+                }
+                if (!ok) {
+                    throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression]", "is not a valid meshopt stream");
                 }
-                std::string n = buffers[i]["name"];
-                asset.buffers[i].name = n ;
-            }
-
-            // byteLength
-            if (buffers[i].find("byteLength") == buffers[i].end()) {
-                throw MisformattedExceptionIsRequired("buffers[i][byteLength]");
-            } else if (!buffers[i]["byteLength"].is_number()) {
-                throw MisformattedExceptionNotNumber("buffers[i][byteLength]");
-            }
-            asset.buffers[i].byteLength = buffers[i]["byteLength"].get<int32_t>();
 
-            // uri
-            if (buffers[i].find("uri") != buffers[i].end()) {
-                if (!buffers[i]["uri"].is_string()) {
-                    throw MisformattedExceptionNotString("buffers[i][uri]");
+                // 过滤器只用于ATTRIBUTES
+                bool attributes = meshopt.mode == BufferView::Meshopt::Mode::Attributes;
+                switch (meshopt.filter) {
+                    case BufferView::Meshopt::Filter::None:
+                        break;
+                    case BufferView::Meshopt::Filter::Octahedral:
+                        if (!attributes || (meshopt.byteStride != 4 && meshopt.byteStride != 8)) {
+                            throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][filter]", "does not match the byteStride");
+                        }
+                        meshoptOctahedralFilter(dst, meshopt.count, meshopt.byteStride);
+                        break;
+                    case BufferView::Meshopt::Filter::Quaternion:
+                        if (!attributes || meshopt.byteStride != 8) {
+                            throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][filter]", "does not match the byteStride");
+                        }
+                        meshoptQuaternionFilter(dst, meshopt.count, meshopt.byteStride);
+                        break;
+                    case BufferView::Meshopt::Filter::Exponential:
+                        if (!attributes) {
+                            throw MisformattedException("bufferViews[i][extensions][EXT_meshopt_compression][filter]", "does not match the byteStride");
+                        }
+                        meshoptExponentialFilter(dst, meshopt.count, meshopt.byteStride);
+                        break;
                 }
-                std::string URI =  buffers[i]["uri"]; ;
-                asset.buffers[i].uri = URI;
             }
+        });
 
-            loadBufferData(asset, asset.buffers[i]);
+        // 解码结果从buffer的开头开始
+        for (size_t k = 0; k < compressed.size(); ++k) {
+            BufferView& bufferView = asset.bufferViews[compressed[k]];
+            bufferView.buffer = first + k;
+            bufferView.byteOffset = 0;
         }
     }
 
     /**
      * @brief 测试读取的数据
      *  将读取的数据中的索引indices和顶点坐标position输出为obj模型
+     *  Debug dump only (LoadOptions::dumpObj); the culling path uses the
+     *  decoded arrays directly.
      */
-    void testPVData(std::vector<float> vV ,std::vector<float> vnV ,std::vector<int> iV){
+    // 把所有instance展开到世界坐标写成obj
+    void testPVData(const Asset& asset){
         
         FILE* file = fopen("./scene.obj", "w");
         if (!file) {
@@ -541,346 +911,522 @@ namespace gltf {
             system("PAUSE");
             exit(0);
         }
-        for(int i=0;i<vV.size();i=i+3){
-            fprintf(file,"v %lf %lf %lf\n",vV[i],vV[i+1],vV[i+2]); 
-            fprintf(file,"vn %lf %lf %lf\n",vnV[i],vnV[i+1],vnV[i+2]); 
+        std::vector<float> world;
+        for(const Instance& instance : asset.instances){
+            const Geometry& geometry = asset.geometries[instance.geometry];
+            const float* local = asset.vV.data() + geometry.vertexOffset * 3;
+            const float* vnV = asset.vnV.empty() ? nullptr : asset.vnV.data() + geometry.vertexOffset * 3;
+            world.assign(local, local + geometry.vertexCount * 3);
+            transformPositions(asset.nodes[instance.node].worldMatrix, world.data(), geometry.vertexCount);
+            for(size_t i=0;i<world.size();i=i+3){
+                fprintf(file,"v %lf %lf %lf\n",world[i],world[i+1],world[i+2]); 
+                if (vnV) {
+                    fprintf(file,"vn %lf %lf %lf\n",vnV[i],vnV[i+1],vnV[i+2]); 
+                }
+            }
         }
-        for(int i=0;i<iV.size();i=i+3){
-            fprintf(file,"f %d//%d %d//%d %d//%d\n",iV[i]+1,iV[i]+1,iV[i+1]+1,iV[i+1]+1,iV[i+2]+1,iV[i+2]+1); 
+        // obj的顶点按instance依次排列，索引换算到展开后的位置
+        size_t base = 0;
+        for(const Instance& instance : asset.instances){
+            const Geometry& geometry = asset.geometries[instance.geometry];
+            const int* iV = asset.iV.data() + geometry.indexOffset;
+            long shift = (long)base - (long)geometry.vertexOffset + 1;
+            for(size_t i=0;i+2<geometry.indexCount;i=i+3){
+                fprintf(file,"f %ld//%ld %ld//%ld %ld//%ld\n",iV[i]+shift,iV[i]+shift,iV[i+1]+shift,iV[i+1]+shift,iV[i+2]+shift,iV[i+2]+shift); 
+            }
+            base += geometry.vertexCount;
         }
         fclose(file);
     }
     
 
     
-    // 从二进制文件读取vertex和indices信息 
+    // buffer的uri对应的文件：相对路径相对于.gltf所在的目录，%XX转义解码为原字符
+    static std::string bufferPath(const Asset& asset, const std::string& uri) {
+        std::string path;
+        for (size_t i = 0; i < uri.size(); ++i) {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit((unsigned char)uri[i + 1])
+                && std::isxdigit((unsigned char)uri[i + 2])) {
+                path.push_back((char)std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                path.push_back(uri[i]);
+            }
+        }
+        if (asset.dirName.empty() || path[0] == '/') {
+            return path;
+        }
+        return asset.dirName + "/" + path;
+    }
+
+    // 将bin文件映射到内存，buffer.data直接指向映射区域
     static void loadBufferData(Asset& asset, Buffer& buffer){
         if (!buffer.uri.size() && buffer.byteLength > 0) {
             throw MisformattedException("buffers[i]", "is not empty but has no uri");
         }
-
-        int vertexSize = 0 ;
-        // std::vector<float> vV ;
-        // std::vector<float> vnV ;
-        int indicesSize = 0 ;
-        // std::vector<int> iV ;
-        int nodesOffset = 0 ;
-
-        // 打开bin文件读取二进制信息
-        std::ifstream ifs(buffer.uri , std::ios::binary | std::ios::in);
-        // 获取顶点和索引数据的 bytelength
-        // for(int i=0;i<asset.bufferViews.size();i++){
-        //     if(asset.bufferViews[i].target == 34962)
-        //         vertexSize += asset.bufferViews[i].byteLength / 4 ;
-        //     else if(asset.bufferViews[i].target == 34963)
-        //         indicesSize += asset.bufferViews[i].byteLength /2 ;  // ???? 问题：有些索引bytelength是2 有些是1 
-        // }
-
-        // float *position = new float[vertexSize];
-        std::cout<<"loadbufferdata here!\n"<<asset.nodes.size() <<std::endl;
-        for(int i=0;i<asset.nodes.size();i++){
-            std::cout<<"loadbufferdata here 2!"<<std::endl;
-            // 为了方便测试  从有效的meshes开始读
-            if(asset.nodes[i].mesh != -1){
-                std::cout<<"loadbufferdata here 3!"<<std::endl;
-                int positionIndexOfAcc = asset.meshes[asset.nodes[i].mesh].primitives[0].attributes["POSITION"] ;
-                int normalIndexOfAcc = asset.meshes[asset.nodes[i].mesh].primitives[0].attributes["NORMAL"] ;
-                int indiceIndexOfAcc = asset.meshes[asset.nodes[i].mesh].primitives[0].indices ;
-                asset.meshesName.push_back(asset.nodes[i].name);   // meshname
-                // indicesCount是accessor里的count
-                int indicesCount = asset.accessors[indiceIndexOfAcc].count ;
-                int bvI = asset.accessors[indiceIndexOfAcc].bufferView ;
-                int indicesOffset = asset.accessors[indiceIndexOfAcc].byteOffset + asset.bufferViews[bvI].byteOffset ;  // offset应该是accessor的byteoffset和bufferview的byteoffset之和 ( 应 该 是 吧 )
-                // int indicesByteLength = asset.bufferViews[bvI].byteLength ;
-                // int typeLength = indicesByteLength / indicesCount ;  // 索引bytelength 是 1或者2 
-               
-
-
-                int c = 0 ; // ifc.gcount : 每次读取的字节数
-                if(asset.accessors[indiceIndexOfAcc].componentType == 5121){
-                    int indicesByteLength = asset.accessors[indiceIndexOfAcc].count  ;
-                    uint8_t *indices = new uint8_t[indicesCount];    
-                    std::cout<<indicesOffset<<std::endl;
-                    ifs.seekg(indicesOffset ,std::ios::beg) ;   // 读指针移动到offset处 
-                    ifs.read((char*)indices,indicesByteLength)  ;  // 读bytelength个字符
-                    c = ifs.gcount() ;
-                    std::cout<<"read indices size : "<< c <<std::endl;
-                    for(int j=0;j<c;j+=3){
-                        
-                        asset.iV.push_back(indices[j]+nodesOffset);
-                        asset.iV.push_back(indices[j+1]+nodesOffset);
-                        asset.iV.push_back(indices[j+2]+nodesOffset);
-                        // std::cout<< indices[i]<<" "<<indices[i+1]<<" "<<indices[i+2]<<std::endl;
-                    }
-                    asset.meshesLength.push_back(c/3);    // 每个mesh的三角形的数量
-                }             
-                else if(asset.accessors[indiceIndexOfAcc].componentType == 5123){
-                    int indicesByteLength = asset.accessors[indiceIndexOfAcc].count *2 ;
-                    uint16_t *indices = new uint16_t[indicesCount];
-                    ifs.seekg(indicesOffset ,std::ios::beg) ;   // 读指针移动到offset处 
-                    ifs.read((char*)indices,indicesByteLength)  ;  //  读bytelength个字符
-                    c = ifs.gcount() ;
-                    std::cout<<"read indices size : "<< c <<std::endl;
-                    for(int j=0;j<c/2;j+=3){
-                        asset.iV.push_back(indices[j]+nodesOffset);
-                        asset.iV.push_back(indices[j+1]+nodesOffset);
-                        asset.iV.push_back(indices[j+2]+nodesOffset);
-                        //std::cout<< indices[j]<<" "<<indices[j+1]<<" "<<indices[j+2]<<std::endl;
-                    }
-                    asset.meshesLength.push_back(c/2/3);    // 每个mesh的三角形的数量
-                }else if(asset.accessors[indiceIndexOfAcc].componentType == 5125){
-                    int indicesByteLength = asset.accessors[indiceIndexOfAcc].count *4 ;
-                    uint32_t *indices = new uint32_t[indicesCount];
-                    ifs.seekg(indicesOffset ,std::ios::beg) ;   // 读指针移动到offset处 
-                    ifs.read((char*)indices,indicesByteLength)  ;  //  读bytelength个字符
-                    c = ifs.gcount() ;
-                    std::cout<<"read indices size : "<< c <<std::endl;
-                    for(int j=0;j<c/4;j+=3){
-                        asset.iV.push_back(indices[j]+nodesOffset);
-                        asset.iV.push_back(indices[j+1]+nodesOffset);
-                        asset.iV.push_back(indices[j+2]+nodesOffset);
-                        //std::cout<< indices[j]<<" "<<indices[j+1]<<" "<<indices[j+2]<<std::endl;
-                    }
-                    asset.meshesLength.push_back(c/4/3);    // 每个mesh的三角形的数量
-                }
-
-                
-                
-
-                // position 的信息  v
-                int positionsCount = asset.accessors[positionIndexOfAcc].count;
-                int bvP = asset.accessors[positionIndexOfAcc].bufferView ;
-                int positionsOffset = asset.accessors[positionIndexOfAcc].byteOffset + asset.bufferViews[bvP].byteOffset ;
-                
-                float *positions = new float[positionsCount*3] ;   // 一个position三个坐标，三个float 
-                ifs.seekg(positionsOffset ,std::ios::beg) ;
-                ifs.read((char*)positions,positionsCount*3*4) ; // 三个坐标，每个坐标长度4字节 ，
-                //std::cout<<"read positions size : "<< ifs.gcount() <<std::endl;
-                int d =  ifs.gcount() ;
-                nodesOffset = nodesOffset + d/12 ;
-                std::cout<<"read positions size : "<< d <<std::endl;
-                for(int j=0;j<d/4;j+=3){
-                    float f0=positions[j],f1=positions[j+1],f2=positions[j+2];
-                    // positions[j]= asset.nodes[i].matrix[0]*f0 +asset.nodes[i].matrix[1]*f1+asset.nodes[i].matrix[2]*f2+asset.nodes[i].matrix[3];
-                    // positions[j+1]= asset.nodes[i].matrix[4]*f0+asset.nodes[i].matrix[5]*f1+asset.nodes[i].matrix[6]*f2+asset.nodes[i].matrix[7];
-                    // positions[j+2]= asset.nodes[i].matrix[8]*f0+asset.nodes[i].matrix[9]*f1+asset.nodes[i].matrix[10]*f2+asset.nodes[i].matrix[11];
-                    positions[j]= asset.nodes[i].matrix[0]*f0 +asset.nodes[i].matrix[4]*f1+asset.nodes[i].matrix[8]*f2+asset.nodes[i].matrix[12];
-                    positions[j+1]= asset.nodes[i].matrix[1]*f0+asset.nodes[i].matrix[5]*f1+asset.nodes[i].matrix[9]*f2+asset.nodes[i].matrix[13];
-                    positions[j+2]= asset.nodes[i].matrix[2]*f0+asset.nodes[i].matrix[6]*f1+asset.nodes[i].matrix[10]*f2+asset.nodes[i].matrix[14];
-                    asset.vV.push_back(positions[j]);
-                    asset.vV.push_back(positions[j+1]);
-                    asset.vV.push_back(positions[j+2]);
-                    //std::cout<< positions[j]<<"  "<<positions[j+1]<<"  "<<positions[j+2]<<std::endl;
-                }
-                
-
-                //  vn NORMAL
-                int normalCount = asset.accessors[normalIndexOfAcc].count;
-                int bvP_vn = asset.accessors[normalIndexOfAcc].bufferView ;
-                int normalOffset = asset.accessors[normalIndexOfAcc].byteOffset + asset.bufferViews[bvP_vn].byteOffset ;
-                float* normals = new float[normalCount*3];
-                ifs.seekg(normalOffset ,std::ios::beg) ;
-                ifs.read((char*)normals,normalCount*3*4) ; // 三个坐标，每个坐标长度4字节 ，
-                int g = ifs.gcount();
-                std::cout<<"read normals size : "<< d <<std::endl;
-                for(int j=0;j<g/4;j+=3){
-                    asset.vnV.push_back(normals[j]);
-                    asset.vnV.push_back(normals[j+1]);
-                    asset.vnV.push_back(normals[j+2]);
-                    //std::cout<< positions[j]<<"  "<<positions[j+1]<<"  "<<positions[j+2]<<std::endl;
-                }
-               //  break ;   // 测试用 
-            }
-
-
+        if (!buffer.uri.size()) {
+            return;
         }
-        testPVData(asset.vV, asset.vnV, asset.iV);
-
-        ifs.close();
 
-
-    }
-
-    
-
-    // bufferview: 描述buffers中的数据（从哪到哪是顶点or索引）
-    // 根据“bytelength”、“byteoffset”、“bytestride”将buffer中的二进制数据分为顶点、索引等等
-    static void loadBufferViews(Asset& asset, nlohmann::json& json) {
-        if (json.find("bufferViews") == json.end()) {
+        // 内嵌数据 data:[<mediatype>];base64,<data>，直接解码到buffer自己的存储中
+        if (buffer.uri.compare(0, 5, "data:") == 0) {
+            size_t comma = buffer.uri.find(',');
+            if (comma == std::string::npos || comma < 12 || buffer.uri.compare(comma - 7, 7, ";base64") != 0) {
+                throw MisformattedException("buffers[i][uri]", "is a data uri without base64 payload");
+            }
+            const char* payload = buffer.uri.data() + comma + 1;
+            size_t payloadLength = buffer.uri.size() - comma - 1;
+            size_t decodedLength = base64DecodedSize(payload, payloadLength);
+            if (decodedLength < buffer.byteLength) {
+                throw MisformattedException("buffers[i][byteLength]", "is larger than its data uri");
+            }
+            std::shared_ptr<uint8_t[]> bytes(new uint8_t[decodedLength]);
+            if (!decodeBase64(payload, payloadLength, bytes.get())) {
+                throw MisformattedException("buffers[i][uri]", "is not valid base64");
+            }
+            buffer.data = bytes.get();
+            buffer.storage = bytes;
             return;
         }
 
-        auto& bufferViews = json["bufferViews"];
-        if (!bufferViews.is_array()) {
-            throw MisformattedExceptionNotArray("bufferViews");
+        auto file = std::make_shared<MappedFile>(bufferPath(asset, buffer.uri));
+        if (file->size() < buffer.byteLength) {
+            throw MisformattedException("buffers[i][byteLength]", "is larger than the file '" + buffer.uri + "'");
         }
+        file->prefetch();
+        buffer.data = file->data();
+        buffer.storage = file;
+    }
 
-        asset.bufferViews.resize(bufferViews.size()) ;
+    static uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
 
-        for (uint32_t i = 0; i < bufferViews.size(); ++i) {
-            // name
-            if (bufferViews[i].find("name") != bufferViews[i].end()) {
-                if (!bufferViews[i]["name"].is_string()) {
-                    throw MisformattedExceptionNotString("bufferViews[i][name]");
-                }
+    // 64位整数的雪崩混合（MurmurHash3的fmix64）
+    static uint64_t mix64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
 
-                std::string n = bufferViews[i]["name"];
-                asset.bufferViews[i].name = n;
+    // 一段字节的哈希：4路独立累加，每次读32字节，不足8字节的尾部补零
+    static uint64_t hashBytes(const uint8_t* p, size_t n, uint64_t seed) {
+        const uint64_t k0 = 0x9E3779B97F4A7C15ull, k1 = 0xC2B2AE3D27D4EB4Full;
+        uint64_t h[4] = {seed + k0, seed + k1, seed - k0, seed - k1};
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                uint64_t w;
+                std::memcpy(&w, p + i + 8 * lane, 8);
+                h[lane] = rotl64(h[lane] + w * k1, 31) * k0;
             }
+        }
+        for (int lane = 0; i < n; i += 8, lane = (lane + 1) & 3) {
+            uint64_t w = 0;
+            std::memcpy(&w, p + i, std::min<size_t>(8, n - i));
+            h[lane] = rotl64(h[lane] + w * k1, 31) * k0;
+        }
+        uint64_t ret = n * k0;
+        for (uint64_t lane : h) {
+            ret = mix64(ret ^ lane);
+        }
+        return ret;
+    }
 
-            // buffer
-            if (bufferViews[i].find("buffer") == bufferViews[i].end()) {
-                throw MisformattedExceptionIsRequired("bufferViews[i][buffer]");
-            }
-            if (!bufferViews[i]["buffer"].is_number()) {
-                throw MisformattedExceptionNotNumber("bufferViews[i][buffer]");
+    // 文件按1MB分块并行哈希，再按块的顺序合并，结果与线程数无关
+    static uint64_t hashFile(const MappedFile& file, uint64_t seed) {
+        const size_t kBlock = size_t(1) << 20;
+        size_t blocks = (file.size() + kBlock - 1) / kBlock;
+        std::vector<uint64_t> hashes(blocks);
+        ThreadPool::global().parallel_for(0, blocks, 1, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                size_t offset = b * kBlock;
+                hashes[b] = hashBytes(file.data() + offset, std::min(kBlock, file.size() - offset), b);
             }
-            asset.bufferViews[i].buffer = bufferViews[i]["buffer"].get<int32_t>();
+        });
+        return hashBytes((const uint8_t*)hashes.data(), hashes.size() * sizeof(uint64_t), seed ^ file.size());
+    }
 
-            // byteOffset (改)
-            if (bufferViews[i].find("byteOffset") != bufferViews[i].end()) {
-                ///throw MisformattedExceptionIsRequired("bufferViews[i][byteOffset]");
-                if (!bufferViews[i]["byteOffset"].is_number()) {
-                    throw MisformattedExceptionNotNumber("bufferViews[i][byteOffset]");
-                }
-                asset.bufferViews[i].byteOffset = bufferViews[i]["byteOffset"].get<int32_t>();
+    uint64_t contentHash(const Asset& asset, const std::string& fileName) {
+        uint64_t hash = hashFile(MappedFile(fileName), 0);
+        std::vector<char> referenced = referencedBuffers(asset);
+        for (size_t i = 0; i < asset.buffers.size(); ++i) {
+            const Buffer& buffer = asset.buffers[i];
+            // 内嵌数据和GLB的BIN块已包含在文件本身的哈希中；不被引用的buffer不会被读取
+            if (!referenced[i] || !buffer.uri.size() || buffer.uri.compare(0, 5, "data:") == 0) {
+                continue;
             }
-            
-            // byteLength
-            if (bufferViews[i].find("byteLength") == bufferViews[i].end()) {
-                throw MisformattedExceptionIsRequired("bufferViews[i][byteLength]");
-            }
-            if (!bufferViews[i]["byteLength"].is_number()) {
-                throw MisformattedExceptionNotNumber("bufferViews[i][byteLength]");
-            }
-            asset.bufferViews[i].byteLength = bufferViews[i]["byteLength"].get<int32_t>();
+            hash = hashFile(MappedFile(bufferPath(asset, buffer.uri)), hash);
+        }
+        return hash;
+    }
 
-            // byteStride
-            if (bufferViews[i].find("byteStride") != bufferViews[i].end()) {
-                if (!bufferViews[i]["byteStride"].is_number()) {
-                    throw MisformattedExceptionNotNumber("bufferViews[i][byteStride]");
-                }
+    uint32_t componentSize(uint32_t componentType) {
+        switch (componentType) {
+            case 5120:  // BYTE
+            case 5121:  // UNSIGNED_BYTE
+                return 1;
+            case 5122:  // SHORT
+            case 5123:  // UNSIGNED_SHORT
+                return 2;
+            case 5125:  // UNSIGNED_INT
+            case 5126:  // FLOAT
+                return 4;
+            default:
+                return 0;
+        }
+    }
 
-                asset.bufferViews[i].byteStride = bufferViews[i]["byteStride"].get<int32_t>();
-            }
+    uint32_t componentCount(Accessor::Type type) {
+        switch (type) {
+            case Accessor::Type::Scalar: return 1;
+            case Accessor::Type::Vec2: return 2;
+            case Accessor::Type::Vec3: return 3;
+            case Accessor::Type::Vec4: return 4;
+            case Accessor::Type::Mat2: return 4;
+            case Accessor::Type::Mat3: return 9;
+            case Accessor::Type::Mat4: return 16;
+        }
+        return 0;
+    }
 
-            // target
-            if (bufferViews[i].find("target") != bufferViews[i].end()) {
-                if (!bufferViews[i]["target"].is_number()) {
-                    throw MisformattedExceptionNotNumber("bufferViews[i][target]");
-                }
-                asset.bufferViews[i].target = bufferViews[i]["target"].get<uint16_t>();
-            }
+    const uint8_t* bufferViewData(const Asset& asset, int32_t bufferViewIndex, uint64_t byteOffset, uint64_t length) {
+        if (bufferViewIndex < 0 || bufferViewIndex >= (int32_t)asset.bufferViews.size()) {
+            throw MisformattedException("bufferViews[i]", "does not exist");
+        }
+        const BufferView& bufferView = asset.bufferViews[bufferViewIndex];
+        if (bufferView.buffer >= asset.buffers.size()) {
+            throw MisformattedException("bufferViews[i][buffer]", "is not a valid buffer");
+        }
+        const Buffer& buffer = asset.buffers[bufferView.buffer];
 
-            // TODO: bufferViews[i]["extensions"]
-            // TODO: bufferViews[i]["extras"]
+        // 数据必须完整落在bufferView内，bufferView必须完整落在buffer内，否则读映射区域会越界
+        if (byteOffset + length > bufferView.byteLength) {
+            throw MisformattedException("bufferViews[i]", "is too short for the data it holds");
+        }
+        if (bufferView.byteOffset + bufferView.byteLength > buffer.byteLength || !buffer.data) {
+            throw MisformattedException("bufferViews[i]", "does not fit in its buffer");
         }
+        return buffer.data + bufferView.byteOffset + byteOffset;
     }
 
+    const uint8_t* accessorData(const Asset& asset, uint32_t accessorIndex) {
+        if (accessorIndex >= asset.accessors.size()) {
+            throw MisformattedException("accessors[i]", "does not exist");
+        }
+        const Accessor& accessor = asset.accessors[accessorIndex];
+        if (accessor.bufferView < 0 || accessor.bufferView >= (int32_t)asset.bufferViews.size()) {
+            throw MisformattedException("accessors[i][bufferView]", "is not a valid bufferView");
+        }
+        const BufferView& bufferView = asset.bufferViews[accessor.bufferView];
 
+        uint64_t elementSize = (uint64_t)componentSize(accessor.componentType) * componentCount(accessor.type);
+        uint64_t stride = bufferView.byteStride ? bufferView.byteStride : elementSize;
+        uint64_t length = accessor.count ? (accessor.count - 1) * stride + elementSize : 0;
+        if (accessor.byteOffset + length > bufferView.byteLength) {
+            throw MisformattedException("accessors[i]", "does not fit in its bufferView");
+        }
+        return bufferViewData(asset, accessor.bufferView, accessor.byteOffset, length);
+    }
 
-    static void loadAccessors(Asset& asset, nlohmann::json& json) {
-        if (json.find("accessors") == json.end()) {
-            return;
+    // SSE一次处理4个点：3个寄存器的xyz先转置成x/y/z各一个寄存器，计算后再转置回去
+    void transformPositions(const float m[16], float* xyz, size_t count){
+        size_t i = 0;
+#ifdef GLTF_SSE2
+        const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+        const __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+        const __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+        const __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+        for (; i + 4 <= count; i += 4, xyz += 12) {
+            __m128 a = _mm_loadu_ps(xyz);       // x0 y0 z0 x1
+            __m128 b = _mm_loadu_ps(xyz + 4);   // y1 z1 x2 y2
+            __m128 c = _mm_loadu_ps(xyz + 8);   // z2 x3 y3 z3
+            __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                                      _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                                      _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+            // 与标量代码相同的运算顺序，结果逐位一致
+            __m128 tx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m8, z)), m12);
+            __m128 ty = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m9, z)), m13);
+            __m128 tz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_mul_ps(m10, z)), m14);
+            a = _mm_shuffle_ps(_mm_shuffle_ps(tx, ty, _MM_SHUFFLE(0, 0, 0, 0)),
+                               _mm_shuffle_ps(tz, tx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+            b = _mm_shuffle_ps(_mm_shuffle_ps(ty, tz, _MM_SHUFFLE(1, 1, 1, 1)),
+                               _mm_shuffle_ps(tx, ty, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+            c = _mm_shuffle_ps(_mm_shuffle_ps(tz, tx, _MM_SHUFFLE(3, 3, 2, 2)),
+                               _mm_shuffle_ps(ty, tz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            _mm_storeu_ps(xyz, a);
+            _mm_storeu_ps(xyz + 4, b);
+            _mm_storeu_ps(xyz + 8, c);
+        }
+#endif
+        for (; i < count; ++i, xyz += 3) {
+            float f0=xyz[0],f1=xyz[1],f2=xyz[2];
+            xyz[0]= m[0]*f0 + m[4]*f1 + m[8]*f2 + m[12];
+            xyz[1]= m[1]*f0 + m[5]*f1 + m[9]*f2 + m[13];
+            xyz[2]= m[2]*f0 + m[6]*f1 + m[10]*f2 + m[14];
         }
+    }
 
-        auto& accessors = json["accessors"];
+    // 解码一个primitive需要的信息
+    struct PrimitiveJob {
+        uint32_t geometry;
+        uint32_t range;             // geometries[geometry].primitives中的下标
+        uint32_t position;          // accessor
+        int32_t normal;             // accessor，-1：不解码（未请求或primitive没有NORMAL）
+        int32_t indices;            // -1：无索引
+        Primitive::Mode mode;
+    };
+
+    static void decodePrimitive(Asset& asset, const PrimitiveJob& job) {
+        const PrimitiveRange& range = asset.geometries[job.geometry].primitives[job.range];
+
+        // indices：strip/fan展开为三角形列表，并加上之前所有primitive的顶点数
+        decodeTriangles(asset, job.indices, range.vertexCount, job.mode, (int)range.vertexOffset,
+                        asset.iV.data() + range.indexOffset);
+
+        // position 的信息  v（局部坐标，世界变换由instance引用的node给出）
+        // 任意componentType/byteStride都解码成紧密排列的float
+        decodeFloats<3>(asset, job.position, asset.vV.data() + range.vertexOffset * 3);
+
+        //  vn NORMAL（只在LoadOptions::normals时解码；没有NORMAL的primitive填0）
+        if (asset.vnV.empty()) {
+            return;
+        }
+        float* normals = asset.vnV.data() + range.vertexOffset * 3;
+        if (job.normal < 0) {
+            std::fill(normals, normals + range.vertexCount * 3, 0.0f);
+            return;
+        }
+        if (asset.accessors[job.normal].count != range.vertexCount) {
+            throw MisformattedException("meshes[i][primitives][i][attributes][NORMAL]", "count differs from POSITION");
+        }
+        decodeFloats<3>(asset, job.normal, normals);
+    }
 
-        if (!accessors.is_array()) {
-            throw MisformattedExceptionNotArray("accessors");
+    // 焊接时比较的键：Exact为float的位（+0与-0视为相同），Quantized为量化后的网格坐标
+    struct WeldKey {
+        int64_t x, y, z;
+        bool operator==(const WeldKey& rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z; }
+    };
+    struct WeldKeyHash {
+        size_t operator()(const WeldKey& k) const {
+            uint64_t h = (uint64_t)k.x * 0x9E3779B97F4A7C15ull;
+            h = (h ^ (h >> 29) ^ (uint64_t)k.y) * 0xBF58476D1CE4E5B9ull;
+            h = (h ^ (h >> 32) ^ (uint64_t)k.z) * 0x94D049BB133111EBull;
+            return (size_t)(h ^ (h >> 31));
         }
-        std::cout<<"in 1"<<std::endl;
-        asset.accessors.resize(accessors.size());
-        for (uint32_t i = 0; i < accessors.size(); ++i) {
-            // bufferView
-            if (accessors[i].find("bufferView") != accessors[i].end()) {
-                if (!accessors[i]["bufferView"].is_number()) {
-                    throw MisformattedExceptionNotNumber("accessors[i][bufferView]");
-                }
+    };
 
-                asset.accessors[i].bufferView = accessors[i]["bufferView"].get<int32_t>();
+    static WeldKey weldKey(const float* p, const LoadOptions& options) {
+        auto component = [&](float v) -> int64_t {
+            if (options.weld == LoadOptions::Weld::Quantized) {
+                return std::llround(v / options.weldEpsilon);
             }
+            uint32_t bits;
+            v += 0.0f;  // -0 -> +0
+            std::memcpy(&bits, &v, sizeof(bits));
+            return bits;
+        };
+        return WeldKey{component(p[0]), component(p[1]), component(p[2])};
+    }
 
-            // bufferView
-            if (accessors[i].find("bufferView") != accessors[i].end()) {
-                if (!accessors[i]["bufferView"].is_number()) {
-                    throw MisformattedExceptionNotNumber("accessors[i][bufferView]");
+    // 在geometry自己的顶点范围内焊接：唯一顶点按第一次出现的顺序移到范围开头，
+    // 索引改为指向它们；返回唯一顶点数
+    static size_t weldGeometry(Asset& asset, const Geometry& geometry, const LoadOptions& options) {
+        float* vV = asset.vV.data() + geometry.vertexOffset * 3;
+        float* vnV = asset.vnV.empty() ? nullptr : asset.vnV.data() + geometry.vertexOffset * 3;
+        std::vector<uint32_t> remap(geometry.vertexCount);
+        std::unordered_map<WeldKey, uint32_t, WeldKeyHash> unique;
+        unique.reserve(geometry.vertexCount);
+        uint32_t count = 0;
+        for (size_t v = 0; v < geometry.vertexCount; ++v) {
+            auto inserted = unique.emplace(weldKey(vV + v * 3, options), count);
+            remap[v] = inserted.first->second;
+            if (inserted.second) {
+                // count <= v，向前搬移不会覆盖还没读到的顶点
+                if (count != v) {
+                    std::copy(vV + v * 3, vV + v * 3 + 3, vV + count * 3);
+                    if (vnV) {
+                        std::copy(vnV + v * 3, vnV + v * 3 + 3, vnV + count * 3);
+                    }
                 }
-
-                asset.accessors[i].bufferView = accessors[i]["bufferView"].get<int32_t>();
+                ++count;
             }
+        }
+        int* iV = asset.iV.data() + geometry.indexOffset;
+        const int offset = (int)geometry.vertexOffset;
+        for (size_t i = 0; i < geometry.indexCount; ++i) {
+            iV[i] = (int)remap[iV[i] - offset] + offset;
+        }
+        return count;
+    }
 
-            // byteOffset
-            if (accessors[i].find("byteOffset") != accessors[i].end()) {
-                if (!accessors[i]["byteOffset"].is_number()) {
-                    throw MisformattedExceptionNotNumber("accessors[i][byteOffset]");
+    /**
+     * @brief 焊接所有geometry的顶点
+     *  Geometries are welded in parallel, each inside its own vertex range,
+     *  then the unique vertices are packed to the front of vV/vnV and the
+     *  indices are shifted to the new offsets.  Triangles of one geometry
+     *  then share vertices, so each unique vertex is transformed once.
+     */
+    static void weldVertices(Asset& asset, const LoadOptions& options) {
+        std::vector<size_t> uniqueCount(asset.geometries.size());
+        ThreadPool& pool = ThreadPool::global();
+        pool.parallel_for(0, asset.geometries.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t g = begin; g < end; ++g) {
+                uniqueCount[g] = weldGeometry(asset, asset.geometries[g], options);
+            }
+        });
+
+        // 新的偏移不大于原偏移，按顺序向前搬移即可
+        std::vector<size_t> oldOffset(asset.geometries.size());
+        size_t vertexTotal = 0;
+        for (size_t g = 0; g < asset.geometries.size(); ++g) {
+            Geometry& geometry = asset.geometries[g];
+            oldOffset[g] = geometry.vertexOffset;
+            if (vertexTotal != geometry.vertexOffset) {
+                std::copy(asset.vV.begin() + geometry.vertexOffset * 3,
+                          asset.vV.begin() + (geometry.vertexOffset + uniqueCount[g]) * 3,
+                          asset.vV.begin() + vertexTotal * 3);
+                if (!asset.vnV.empty()) {
+                    std::copy(asset.vnV.begin() + geometry.vertexOffset * 3,
+                              asset.vnV.begin() + (geometry.vertexOffset + uniqueCount[g]) * 3,
+                              asset.vnV.begin() + vertexTotal * 3);
                 }
-
-                asset.accessors[i].byteOffset = accessors[i]["byteOffset"].get<uint32_t>();
             }
-
-            // componentType
-            if (accessors[i].find("componentType") == accessors[i].end()) {
-                throw MisformattedExceptionIsRequired("accessors[i][componentType]");
-            } else if (!accessors[i]["componentType"].is_number()) {
-                throw MisformattedExceptionNotNumber("accessors[i][componentType]");
+            geometry.vertexOffset = vertexTotal;
+            geometry.vertexCount = uniqueCount[g];
+            for (PrimitiveRange& range : geometry.primitives) {
+                range.vertexOffset = geometry.vertexOffset;
+                range.vertexCount = geometry.vertexCount;
             }
+            vertexTotal += uniqueCount[g];
+        }
+        asset.vV.resize(vertexTotal * 3);
+        if (!asset.vnV.empty()) {
+            asset.vnV.resize(vertexTotal * 3);
+        }
 
-            asset.accessors[i].componentType = accessors[i]["componentType"].get<uint16_t>();
-
-            // normalized
-            if (accessors[i].find("normalized") != accessors[i].end()) {
-                if (!accessors[i]["normalized"].is_boolean()) {
-                    throw MisformattedExceptionNotBoolean("accessors[i][normalized]");
+        pool.parallel_for(0, asset.geometries.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t g = begin; g < end; ++g) {
+                const Geometry& geometry = asset.geometries[g];
+                const int shift = (int)geometry.vertexOffset - (int)oldOffset[g];
+                int* iV = asset.iV.data() + geometry.indexOffset;
+                for (size_t i = 0; i < geometry.indexCount; ++i) {
+                    iV[i] += shift;
                 }
-
-                asset.accessors[i].normalized = accessors[i]["normalized"].get<bool>() ;
             }
+        });
+    }
 
-            // count
-            if (accessors[i].find("count") == accessors[i].end()) {
-                throw MisformattedExceptionIsRequired("accessors[i][count]");
-            } else if (!accessors[i]["count"].is_number()) {
-                throw MisformattedExceptionNotNumber("accessors[i][count]");
+    // 从buffer（内存映射）中读取vertex和indices信息
+    // 被多个node引用的mesh只解码一次（geometry），每个node记为一个instance。
+    // mesh的所有primitive都会读取，strip/fan在解码时展开为三角形列表。
+    // 第一遍（串行）按accessor的count算出每个primitive在asset.vV/vnV/iV中的偏移，
+    // 第二遍各primitive互不相交地写入自己的位置，可以并行解码。
+    // 包围盒取自POSITION的min/max，不需要为此再遍历顶点
+    static void loadMeshData(Asset& asset, const LoadOptions& options){
+        // 剔除只用到POSITION和索引；--dump-obj的输出带有法线
+        const bool normals = options.normals || options.dumpObj;
+        std::vector<int32_t> geometryOfMesh(asset.meshes.size(), -1);
+        std::vector<PrimitiveJob> jobs;
+        size_t vertexTotal = 0, indexTotal = 0;
+        for(uint32_t i=0;i<asset.nodes.size();i++){
+            // 为了方便测试  从有效的meshes开始读
+            if(asset.nodes[i].mesh == -1){
+                continue;
             }
-
-            asset.accessors[i].count = accessors[i]["count"].get<uint32_t>();
-
-            // type
-            if (accessors[i].find("type") == accessors[i].end()) {
-                throw MisformattedExceptionIsRequired("accessors[i][type]");
-            } else if (!accessors[i]["type"].is_string()) {
-                throw MisformattedExceptionNotString("accessors[i][type]");
+            uint32_t mesh = asset.nodes[i].mesh;
+            if (mesh >= asset.meshes.size()) {
+                throw MisformattedException("nodes[i][mesh]", "is not a valid mesh");
+            }
+            if (geometryOfMesh[mesh] == -1) {
+                Geometry geometry;
+                geometry.mesh = mesh;
+                geometry.vertexOffset = vertexTotal;
+                geometry.indexOffset = indexTotal;
+                geometryOfMesh[mesh] = asset.geometries.size();
+                auto& primitives = asset.meshes[mesh].primitives;
+                for (uint32_t p = 0; p < primitives.size(); ++p) {
+                    Primitive& primitive = primitives[p];
+                    PrimitiveJob job;
+                    job.geometry = geometryOfMesh[mesh];
+                    // 用find查找：operator[]会为缺失的属性插入0，读到无关的accessor
+                    auto positionAttribute = primitive.attributes.find("POSITION");
+                    if (positionAttribute == primitive.attributes.end()) {
+                        throw MisformattedExceptionIsRequired("meshes[i][primitives][j][attributes][POSITION]");
+                    }
+                    job.position = positionAttribute->second;
+                    auto normalAttribute = primitive.attributes.find("NORMAL");
+                    job.normal = normals && normalAttribute != primitive.attributes.end() ? (int32_t)normalAttribute->second : -1;
+                    job.indices = primitive.indices;
+                    job.mode = primitive.mode;
+                    if (job.position >= asset.accessors.size() || job.normal >= (int32_t)asset.accessors.size()) {
+                        throw MisformattedException("meshes[i][primitives][j][attributes]", "references an accessor that does not exist");
+                    }
+                    if (job.indices >= (int32_t)asset.accessors.size()) {
+                        throw MisformattedException("meshes[i][primitives][j][indices]", "is not a valid accessor");
+                    }
+                    PrimitiveRange range;
+                    range.primitive = p;
+                    range.vertexCount = asset.accessors[job.position].count;
+                    size_t count = job.indices < 0 ? range.vertexCount : asset.accessors[job.indices].count;
+                    range.indexCount = triangleCount(primitive.mode, count) * 3;
+                    // points/lines 不参与遮挡剔除
+                    if (range.indexCount == 0) {
+                        continue;
+                    }
+                    range.vertexOffset = vertexTotal;
+                    range.indexOffset = indexTotal;
+                    vertexTotal += range.vertexCount;
+                    indexTotal += range.indexCount;
+                    job.range = geometry.primitives.size();
+                    geometry.primitives.push_back(range);
+                    jobs.push_back(job);
+                }
+                geometry.vertexCount = vertexTotal - geometry.vertexOffset;
+                geometry.indexCount = indexTotal - geometry.indexOffset;
+                asset.geometries.push_back(geometry);
             }
 
-            std::string type = accessors[i]["type"].get<std::string>();
-            if (type == "SCALAR") {
-                asset.accessors[i].type = Accessor::Type::Scalar;
-            } else if (type == "VEC2") {
-                asset.accessors[i].type = Accessor::Type::Vec2;
-            } else if (type == "VEC3") {
-                asset.accessors[i].type = Accessor::Type::Vec3;
-            } else if (type == "VEC4") {
-                asset.accessors[i].type = Accessor::Type::Vec4;
-            } else if (type == "MAT2") {
-                asset.accessors[i].type = Accessor::Type::Mat2;
-            } else if (type == "MAT3") {
-                asset.accessors[i].type = Accessor::Type::Mat3;
-            } else if (type == "MAT4") {
-                asset.accessors[i].type = Accessor::Type::Mat4;
-            } else {
-                throw MisformattedException("accessors[i][type]", "is not a valid type");
+            Instance instance;
+            instance.node = i;
+            instance.geometry = geometryOfMesh[mesh];
+            asset.instances.push_back(instance);
+            asset.meshesName.push_back(asset.nodes[i].name);   // meshname
+            asset.meshesLength.push_back(asset.geometries[instance.geometry].indexCount / 3);    // 每个mesh的三角形的数量
+        }
+        asset.vV.resize(vertexTotal * 3);
+        if (normals) {
+            asset.vnV.resize(vertexTotal * 3);
+        }
+        asset.iV.resize(indexTotal);
+
+        // 小mesh很多时每个任务处理若干个primitive，减少调度开销
+        ThreadPool& pool = ThreadPool::global();
+        size_t grain = std::max<size_t>(1, jobs.size() / (pool.size() * 8));
+        pool.parallel_for(0, jobs.size(), grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                decodePrimitive(asset, jobs[i]);
             }
+        });
 
-            std::cout<<"in 2"<<std::endl;
-            // TODO: accessors[i]["sparse"]
-            // TODO: accessors[i]["extensions"]
-            // TODO: accessors[i]["min"]
-            // TODO: accessors[i]["max"]
+        asset.statistics.decodedVertices = vertexTotal;
+        if (options.weld != LoadOptions::Weld::None) {
+            weldVertices(asset, options);
         }
-    }
+        asset.statistics.vertices = asset.vV.size() / 3;
 
+        if (options.dumpObj) {
+            testPVData(asset);
+        }
+    }
 
+    
 
     static std::string getDirectoryName(const std::string& path) {
         std::size_t found;
@@ -895,37 +1441,120 @@ namespace gltf {
 
 
 
-    Asset load(std::string filename){
+    static uint32_t readUint32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
 
-        nlohmann::json json;
+    /**
+     * @brief 解析GLB（二进制glTF）容器
+     *  Layout: 12-byte header (magic "glTF", version 2, total length), then
+     *  chunks of (length, type, data).  The first chunk must be JSON, an
+     *  optional second chunk is BIN.  Nothing is copied: the JSON range and
+     *  the BIN chunk both point into the file mapping.
+     */
+    static void parseGlb(const std::shared_ptr<MappedFile>& file, const uint8_t*& jsonBegin,
+                         const uint8_t*& jsonEnd, BinaryChunk& bin) {
+        const uint32_t kChunkJson = 0x4E4F534A;  // "JSON"
+        const uint32_t kChunkBin = 0x004E4942;   // "BIN\0"
+
+        const uint8_t* data = file->data();
+        if (file->size() < 12) {
+            throw MisformattedException("glb header", "is truncated");
+        }
+        if (readUint32(data + 4) != 2) {
+            throw MisformattedException("glb header", "has an unsupported version");
+        }
+        uint64_t length = readUint32(data + 8);
+        if (length > file->size()) {
+            throw MisformattedException("glb header", "declares a length larger than the file");
+        }
 
-        {
-            std::ifstream file(filename);
-            if(!file.is_open()){
-                throw std::runtime_error("can't load file!");
+        uint64_t offset = 12;
+        for (uint32_t chunk = 0; offset < length; ++chunk) {
+            if (offset + 8 > length) {
+                throw MisformattedException("glb chunk", "header is truncated");
             }
-            file >> json;
+            uint64_t chunkLength = readUint32(data + offset);
+            uint32_t chunkType = readUint32(data + offset + 4);
+            offset += 8;
+            if (offset + chunkLength > length) {
+                throw MisformattedException("glb chunk", "is larger than the file");
+            }
+
+            if (chunk == 0) {
+                if (chunkType != kChunkJson) {
+                    throw MisformattedException("glb chunk[0]", "is not a JSON chunk");
+                }
+                jsonBegin = data + offset;
+                jsonEnd = data + offset + chunkLength;
+            } else if (chunk == 1 && chunkType == kChunkBin) {
+                bin.data = data + offset;
+                bin.byteLength = chunkLength;
+                bin.file = file;
+            }
+            // 其余（扩展定义的）块忽略
+
+            // 块按4字节对齐
+            offset += (chunkLength + 3) & ~uint64_t(3);
+        }
+
+        if (!jsonBegin) {
+            throw MisformattedExceptionIsRequired("glb chunk[0]");
         }
+    }
+
+    // 映射整个文件；.glb的JSON块和BIN块都直接在映射上解析/引用
+    static std::shared_ptr<MappedFile> mapAsset(const std::string& filename, const uint8_t*& jsonBegin,
+                                                const uint8_t*& jsonEnd, BinaryChunk& bin) {
+        auto file = std::make_shared<MappedFile>(filename);
+        jsonBegin = file->data();
+        jsonEnd = file->data() + file->size();
+        if (file->size() >= 4 && readUint32(file->data()) == 0x46546C67) {  // "glTF"
+            parseGlb(file, jsonBegin, jsonEnd, bin);
+        }
+        return file;
+    }
+
+    Asset load(std::string filename, const LoadOptions& options){
+
+        // 整个文件只映射一次
+        const uint8_t* jsonBegin = nullptr;
+        const uint8_t* jsonEnd = nullptr;
+        BinaryChunk bin;
+        auto file = mapAsset(filename, jsonBegin, jsonEnd, bin);
 
         Asset asset{} ;
         asset.dirName = getDirectoryName(filename);
 
-        loadAsset(asset, json);
-        loadScenes(asset,json);
-        loadMeshes(asset,json);
-        loadNodes(asset,json);
+        // 一遍流式解析，直接填入asset，不构造整棵JSON树
+        GltfSaxHandler handler(asset);
+        parseJson((const char*)jsonBegin, (const char*)jsonEnd, handler);
+        computeWorldTransforms(asset);
+        if (!options.meshData) {
+            return asset;
+        }
+
+        loadBuffers(asset,bin);
+        decodeMeshoptBufferViews(asset);
+        loadMeshData(asset, options);
 
-        // 应该是先读bufferview和accessor 
-        loadBufferViews(asset,json);
-        loadAccessors(asset,json);
-        loadBuffers(asset,json);
-        
-        
 
         return asset;
 
     }
 
+    void loadMeshData(Asset& asset, const std::string& fileName, const LoadOptions& options) {
+        // JSON已经解析过，映射只用来找到GLB的BIN块
+        const uint8_t* jsonBegin = nullptr;
+        const uint8_t* jsonEnd = nullptr;
+        BinaryChunk bin;
+        auto file = mapAsset(fileName, jsonBegin, jsonEnd, bin);
+
+        loadBuffers(asset, bin);
+        decodeMeshoptBufferViews(asset);
+        loadMeshData(asset, options);
+    }
+
 
 
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -23,7 +26,9 @@ namespace gltf{
         int32_t mesh = -1 ;
         int32_t skin = -1;
 
-        float matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};    // T*R*S
+        float matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};    // T*R*S，局部变换（列主序）
+        // 世界变换 = 父节点worldMatrix * matrix，load()时沿场景图算好
+        float worldMatrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
         float translation[3] = { 0, 0, 0 };    // 或者改为Vec3类型
         float rotation[4] = {0, 0, 0, 1};
         float scale[3] = {1, 1, 1};
@@ -68,29 +73,42 @@ namespace gltf{
     struct Buffer{
         std::string name;
         std::string uri;
-        uint32_t byteLength = 0;
-       // 
-        char* data = nullptr; 
+        uint64_t byteLength = 0;
 
-        // float* position = nullptr;
-        // float* normal = nullptr;
-        // float* tangent = nullptr;
+        // 指向buffer的二进制数据（byteLength字节），直接指向内存映射，不做拷贝
+        // Valid for as long as `storage` is alive.
+        const uint8_t* data = nullptr;
+        // Keeps the memory the data pointer refers to alive (the mapped
+        // file); shared so that copies of an Asset stay cheap.
+        std::shared_ptr<const void> storage;
 
-        std::vector<float>positions ;
-        std::vector<int>indices ;
-        // uint32_t* indice = nullptr ;
+        // EXT_meshopt_compression的占位buffer（fallback）：没有数据，
+        // 引用它的bufferView都是压缩的，解码后改为指向解码结果
+        bool fallback = false;
 
     };
 
     struct BufferView{
         std::string name ;
         uint32_t buffer;  // buffer的索引
-        uint32_t byteOffset = 0 ;
-        uint32_t byteLength = 0 ;
+        uint64_t byteOffset = 0 ;
+        uint64_t byteLength = 0 ;
         uint32_t byteStride = 0 ;
 
         uint32_t target = 0;
 
+        // EXT_meshopt_compression：压缩数据在buffers[buffer]中的位置，
+        // 解码为count个byteStride字节的元素；count为0表示没有压缩
+        struct Meshopt {
+            uint32_t buffer = 0;
+            uint64_t byteOffset = 0;
+            uint64_t byteLength = 0;
+            uint32_t byteStride = 0;
+            uint32_t count = 0;
+            enum class Mode : uint8_t { Attributes, Triangles, Indices } mode = Mode::Attributes;
+            enum class Filter : uint8_t { None, Octahedral, Quaternion, Exponential } filter = Filter::None;
+        } meshopt;
+
         // enum class TargetType : uint16_t {
         //     None = 0,
         //     ArrayBuffer = 34962,
@@ -127,8 +145,25 @@ namespace gltf{
         } type;
 
         uint32_t count;
-        std::vector<int32_t> max;
-		std::vector<int32_t> min;
+        // 每个分量的最大/最小值（未归一化的原始值，已包含sparse的替换），
+        // 没有给出时为空；POSITION必须给出
+        std::vector<float> max;
+        std::vector<float> min;
+
+        // 稀疏存储：在bufferView的数据（没有bufferView时全为0）上替换count个元素，
+        // indices严格递增，values与accessor的componentType、type相同，都紧密排列
+        struct Sparse {
+            uint32_t count = 0;     // 0：不是稀疏accessor
+            struct {
+                int32_t bufferView = -1;
+                uint32_t byteOffset = 0;
+                uint32_t componentType = 0;     // 5121、5123、5125
+            } indices;
+            struct {
+                int32_t bufferView = -1;
+                uint32_t byteOffset = 0;
+            } values;
+        } sparse;
 
     };
 
@@ -183,6 +218,29 @@ namespace gltf{
 
     };
 
+    // geometry中一个primitive在vV/vnV/iV中的位置（strip/fan已展开为三角形列表）
+    struct PrimitiveRange {
+        uint32_t primitive;     // 在meshes[mesh].primitives中的下标
+        // 以顶点为单位；焊接后各primitive共用geometry的顶点，这里为geometry的整个顶点范围
+        size_t vertexOffset = 0, vertexCount = 0;
+        size_t indexOffset = 0, indexCount = 0;
+    };
+
+    // 被node引用的mesh只解码一次，记录它在vV/vnV/iV中的位置；
+    // 各primitive依次排列，points/lines没有三角形，不在其中
+    struct Geometry {
+        uint32_t mesh;
+        size_t vertexOffset = 0, vertexCount = 0;   // 以顶点为单位
+        size_t indexOffset = 0, indexCount = 0;
+        std::vector<PrimitiveRange> primitives;
+    };
+
+    // mesh在场景中的一次出现：nodes[node].worldMatrix 作用于 geometries[geometry]
+    struct Instance {
+        uint32_t node;
+        uint32_t geometry;
+    };
+
     struct Asset{
 
         struct Metadata{
@@ -206,12 +264,26 @@ namespace gltf{
         std::string dirName;
 
 
-         // vertex与indices数据
+         // vertex与indices数据：每个geometry一段，顶点为mesh的局部坐标，
+         // 索引已加上geometry的vertexOffset
         std::vector<float> vV ;
-        std::vector<float> vnV ;
+        std::vector<float> vnV ;    // 只在LoadOptions::normals时解码，否则为空
+
         std::vector<int> iV ;
 
-        // meshes的大小和meshname
+        std::vector<Geometry> geometries;
+        // 按node顺序，每个带mesh的node一个
+        std::vector<Instance> instances;
+
+        // 加载统计
+        struct Statistics {
+            size_t decodedVertices = 0;     // 焊接前（各primitive解码出）的顶点数
+            size_t vertices = 0;            // vV中的顶点数
+            // 焊接比：平均每个唯一顶点合并了几个解码出的顶点
+            double weldRatio() const { return vertices ? double(decodedVertices) / vertices : 1.0; }
+        } statistics;
+
+        // 每个instance的三角形数量和node name
         std::vector<int> meshesLength ;
         std::vector<std::string> meshesName ;
 
@@ -232,13 +304,76 @@ namespace gltf{
 
 
 
+    // 加载选项
+    struct LoadOptions {
+        // 把解码后的顶点和索引写到 ./scene.obj（仅用于调试）
+        bool dumpObj = false;
+
+        // 顶点焊接：geometry内位置相同的顶点合并为一个，索引改为指向唯一顶点
+        // （合并后的顶点保留第一个出现的顶点的法线）
+        enum class Weld : uint8_t {
+            None,
+            Exact,      // 位置逐位相同
+            Quantized,  // round(位置 / weldEpsilon) 相同
+        } weld = Weld::None;
+        float weldEpsilon = 1e-5f;  // 必须为有限的正数
+
+        // 解码NORMAL到vnV。剔除只需要POSITION和索引，导出时需要携带法线才打开；
+        // 不打开时NORMAL不被读取，vnV为空
+        bool normals = false;
+
+        // 为false时只解析JSON并计算节点的世界矩阵，不读取buffer也不解码mesh
+        // （例如mesh数据从缓存中恢复时）
+        bool meshData = true;
+    };
+
     /**
      * @brief  
      * 
      * @param fileName 文件名
+     * @param options 加载选项
      * @return Asset 
      */
-    Asset load(std::string fileName) ;
+    Asset load(std::string fileName, const LoadOptions& options = LoadOptions()) ;
+
+    /**
+     * @brief 补全只解析了JSON的asset
+     *  Reads the buffers of `asset`, loaded from `fileName` with
+     *  `meshData = false`, and decodes its meshes as `load` would have done
+     *  with `options`, without parsing the JSON a second time.
+     */
+    void loadMeshData(Asset& asset, const std::string& fileName, const LoadOptions& options);
+
+    /**
+     * @brief 资源内容的64位哈希
+     *  Hashes the bytes of `fileName` (a .gltf or .glb) and of every external
+     *  buffer file a bufferView references, in buffer order.  Data uris and the GLB BIN
+     *  chunk are part of the file itself.  Any change to the asset's content
+     *  changes the hash (with overwhelming probability); the file names and
+     *  timestamps do not take part.
+     *
+     * @param asset `fileName` loaded at least with `meshData = false`
+     */
+    uint64_t contentHash(const Asset& asset, const std::string& fileName);
+
+    // componentType 对应的字节数（5120..5126），未知类型返回0
+    uint32_t componentSize(uint32_t componentType);
+    // 每个元素的分量个数（SCALAR=1, VEC3=3, MAT4=16 ...）
+    uint32_t componentCount(Accessor::Type type);
+
+    /**
+     * @brief 访问器在buffer中的起始地址
+     *  Resolves accessor -> bufferView -> buffer and returns a pointer to the
+     *  first element inside the buffer's mapping.  Throws a
+     *  MisformattedException when the accessor does not fit in its buffer.
+     */
+    const uint8_t* accessorData(const Asset& asset, uint32_t accessor);
+
+    // bufferView中 [byteOffset, byteOffset + length) 的起始地址，越界时抛出MisformattedException
+    const uint8_t* bufferViewData(const Asset& asset, int32_t bufferView, uint64_t byteOffset, uint64_t length);
+
+    // xyz紧密排列的count个点原地乘以列主序矩阵m（例如node的worldMatrix）
+    void transformPositions(const float m[16], float* xyz, size_t count);
 
 
 }
\ No newline at end of file
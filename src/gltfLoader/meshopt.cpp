@@ -0,0 +1,357 @@
+#include "meshopt.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace gltf {
+
+    static const uint8_t kVertexHeader = 0xa0;
+    static const uint8_t kIndexHeader = 0xe0;
+    static const uint8_t kSequenceHeader = 0xd0;
+
+    static const size_t kByteGroupSize = 16;
+    static const size_t kByteGroupDecodeLimit = 24;    // 一个字节组最多读取的字节数（含头之外的余量）
+    static const size_t kVertexBlockSizeBytes = 8192;
+    static const size_t kVertexBlockMaxSize = 256;
+    static const size_t kTailMaxSize = 32;
+
+    // ---- ATTRIBUTES ----
+
+    // 一个块中的顶点数：整个块不超过8KB，且按16个一组对齐
+    static size_t vertexBlockSize(size_t byteStride) {
+        size_t result = (kVertexBlockSizeBytes / byteStride) & ~(kByteGroupSize - 1);
+        return result < kVertexBlockMaxSize ? result : kVertexBlockMaxSize;
+    }
+
+    // 16个值为一组，每个值用bits位存，全1表示真实值在其后的字节里（高位在前）
+    template <int Bits>
+    static const uint8_t* decodeBytesGroup(const uint8_t* data, uint8_t* out) {
+        const uint8_t sentinel = (1 << Bits) - 1;
+        const uint8_t* extra = data + kByteGroupSize * Bits / 8;
+        for (size_t i = 0; i < kByteGroupSize * Bits / 8; ++i) {
+            uint8_t byte = data[i];
+            for (int k = 0; k < 8 / Bits; ++k) {
+                uint8_t enc = byte >> (8 - Bits);
+                byte = (uint8_t)(byte << Bits);
+                *out++ = enc == sentinel ? *extra : enc;
+                extra += enc == sentinel;
+            }
+        }
+        return extra;
+    }
+
+    // size个字节（16的倍数）：先是每组2位的位宽选择（0/2/4/8位），再是各组数据
+    static const uint8_t* decodeBytes(const uint8_t* data, const uint8_t* end, uint8_t* out, size_t size) {
+        const uint8_t* header = data;
+        size_t headerSize = (size / kByteGroupSize + 3) / 4;
+        if ((size_t)(end - data) < headerSize) {
+            return nullptr;
+        }
+        data += headerSize;
+        for (size_t i = 0; i < size; i += kByteGroupSize) {
+            if ((size_t)(end - data) < kByteGroupDecodeLimit) {
+                return nullptr;
+            }
+            size_t group = i / kByteGroupSize;
+            switch ((header[group / 4] >> ((group % 4) * 2)) & 3) {
+                case 0: std::memset(out + i, 0, kByteGroupSize); break;
+                case 1: data = decodeBytesGroup<2>(data, out + i); break;
+                case 2: data = decodeBytesGroup<4>(data, out + i); break;
+                default:
+                    std::memcpy(out + i, data, kByteGroupSize);
+                    data += kByteGroupSize;
+                    break;
+            }
+        }
+        return data;
+    }
+
+    // 顶点按字节转置存储，每个字节位置是相对上一个顶点的zigzag差分
+    static const uint8_t* decodeVertexBlock(const uint8_t* data, const uint8_t* end, uint8_t* out, size_t count,
+                                            size_t byteStride, uint8_t last[256]) {
+        uint8_t deltas[kVertexBlockMaxSize];
+        size_t aligned = (count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+        for (size_t k = 0; k < byteStride; ++k) {
+            data = decodeBytes(data, end, deltas, aligned);
+            if (!data) {
+                return nullptr;
+            }
+            uint8_t p = last[k];
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t d = deltas[i];
+                p = (uint8_t)(p + ((d >> 1) ^ (uint8_t)-(d & 1)));
+                out[i * byteStride + k] = p;
+            }
+            last[k] = p;
+        }
+        return data;
+    }
+
+    bool decodeMeshoptVertices(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length) {
+        if (byteStride == 0 || byteStride > 256 || byteStride % 4 != 0) {
+            return false;
+        }
+        const uint8_t* end = src + length;
+        if (length < 1 + byteStride || (src[0] & 0xf0) != kVertexHeader || (src[0] & 0x0f) != 0) {
+            return false;
+        }
+        const uint8_t* data = src + 1;
+
+        // 第一个顶点的基准值在流的末尾
+        uint8_t last[256];
+        std::memcpy(last, end - byteStride, byteStride);
+
+        const size_t blockSize = vertexBlockSize(byteStride);
+        for (size_t offset = 0; offset < count; offset += blockSize) {
+            size_t n = offset + blockSize < count ? blockSize : count - offset;
+            data = decodeVertexBlock(data, end, dst + offset * byteStride, n, byteStride, last);
+            if (!data) {
+                return false;
+            }
+        }
+        size_t tailSize = byteStride < kTailMaxSize ? kTailMaxSize : byteStride;
+        return (size_t)(end - data) == tailSize;
+    }
+
+    // ---- TRIANGLES / INDICES ----
+
+    static uint32_t decodeVByte(const uint8_t*& data) {
+        uint8_t lead = *data++;
+        if (lead < 128) {
+            return lead;
+        }
+        uint32_t result = lead & 127;
+        for (uint32_t shift = 7; shift < 35; shift += 7) {
+            uint8_t group = *data++;
+            result |= (uint32_t)(group & 127) << shift;
+            if (group < 128) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    // 相对上一个自由索引的zigzag差分
+    static uint32_t decodeIndex(const uint8_t*& data, uint32_t last) {
+        uint32_t v = decodeVByte(data);
+        return last + ((v >> 1) ^ (uint32_t)-(int32_t)(v & 1));
+    }
+
+    static void writeIndex(uint8_t* dst, size_t i, size_t byteStride, uint32_t index) {
+        if (byteStride == 2) {
+            uint16_t v = (uint16_t)index;
+            std::memcpy(dst + i * 2, &v, 2);
+        } else {
+            std::memcpy(dst + i * 4, &index, 4);
+        }
+    }
+
+    // 编码器与解码器维护完全相同的FIFO：16条最近的边、16个最近的顶点
+    struct TriangleFifo {
+        uint32_t edges[16][2];
+        uint32_t vertices[16];
+        size_t edgeOffset = 0, vertexOffset = 0;
+
+        TriangleFifo() {
+            std::memset(edges, -1, sizeof(edges));
+            std::memset(vertices, -1, sizeof(vertices));
+        }
+        void pushEdge(uint32_t a, uint32_t b) {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) & 15;
+        }
+        void pushVertex(uint32_t v, bool push = true) {
+            vertices[vertexOffset] = v;
+            vertexOffset = (vertexOffset + push) & 15;
+        }
+    };
+
+    bool decodeMeshoptTriangles(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length) {
+        if ((byteStride != 2 && byteStride != 4) || count % 3 != 0) {
+            return false;
+        }
+        // 最短的合法流：头、每个三角形1字节编码、末尾16字节的codeaux表
+        if (length < 1 + count / 3 + 16 || (src[0] & 0xf0) != kIndexHeader) {
+            return false;
+        }
+        const int version = src[0] & 0x0f;
+        if (version > 1) {
+            return false;
+        }
+        // 版本1中fec为13、14表示上一个自由索引-1、+1
+        const int fecMax = version >= 1 ? 13 : 15;
+
+        const uint8_t* code = src + 1;
+        const uint8_t* data = code + count / 3;
+        const uint8_t* dataEnd = src + length - 16;
+        const uint8_t* codeaux = dataEnd;
+
+        TriangleFifo fifo;
+        uint32_t next = 0, last = 0;
+        for (size_t i = 0; i < count; i += 3) {
+            // 一个三角形最多读16字节，codeaux表保证读取不越界
+            if (data > dataEnd) {
+                return false;
+            }
+            uint8_t codetri = *code++;
+            uint32_t a, b, c;
+            if (codetri < 0xf0) {
+                // 复用FIFO中的一条边
+                int fe = codetri >> 4;
+                a = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][0];
+                b = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][1];
+                int fec = codetri & 15;
+                if (fec < fecMax) {
+                    bool fresh = fec == 0;
+                    c = fresh ? next++ : fifo.vertices[(fifo.vertexOffset - 1 - fec) & 15];
+                    fifo.pushVertex(c, fresh);
+                } else {
+                    last = c = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(data, last);
+                    fifo.pushVertex(c);
+                }
+                fifo.pushEdge(c, b);
+                fifo.pushEdge(a, c);
+            } else {
+                int fea, feb, fec;
+                if (codetri < 0xfe) {
+                    // codeaux取自表，a总是新顶点，b、c不会是自由索引
+                    uint8_t aux = codeaux[codetri & 15];
+                    fea = 0;
+                    feb = aux >> 4;
+                    fec = aux & 15;
+                } else {
+                    uint8_t aux = *data++;
+                    fea = codetri == 0xfe ? 0 : 15;
+                    feb = aux >> 4;
+                    fec = aux & 15;
+                    if (aux == 0) {
+                        next = 0;   // 重置
+                    }
+                }
+                // 三个顶点的next都在读自由索引之前递增，与编码器一致
+                a = fea == 0 ? next++ : 0;
+                b = feb == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - feb) & 15];
+                c = fec == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - fec) & 15];
+                if (fea == 15) {
+                    last = a = decodeIndex(data, last);
+                }
+                if (feb == 15) {
+                    last = b = decodeIndex(data, last);
+                }
+                if (fec == 15) {
+                    last = c = decodeIndex(data, last);
+                }
+                fifo.pushVertex(a);
+                fifo.pushVertex(b, feb == 0 || feb == 15);
+                fifo.pushVertex(c, fec == 0 || fec == 15);
+                fifo.pushEdge(b, a);
+                fifo.pushEdge(c, b);
+                fifo.pushEdge(a, c);
+            }
+            writeIndex(dst, i + 0, byteStride, a);
+            writeIndex(dst, i + 1, byteStride, b);
+            writeIndex(dst, i + 2, byteStride, c);
+        }
+        // 数据必须恰好在codeaux表之前结束
+        return data == dataEnd;
+    }
+
+    bool decodeMeshoptIndices(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length) {
+        if (byteStride != 2 && byteStride != 4) {
+            return false;
+        }
+        // 最短的合法流：头、每个索引1字节、末尾4字节
+        if (length < 1 + count + 4 || (src[0] & 0xf0) != kSequenceHeader || (src[0] & 0x0f) > 1) {
+            return false;
+        }
+        const uint8_t* data = src + 1;
+        const uint8_t* dataEnd = src + length - 4;
+
+        // 两条基准序列，最低位选择相对哪一条做差分
+        uint32_t last[2] = {0, 0};
+        for (size_t i = 0; i < count; ++i) {
+            // 一个索引最多读5字节，末尾4字节保证读取不越界
+            if (data >= dataEnd) {
+                return false;
+            }
+            uint32_t v = decodeVByte(data);
+            uint32_t baseline = v & 1;
+            v >>= 1;
+            uint32_t index = last[baseline] + ((v >> 1) ^ (uint32_t)-(int32_t)(v & 1));
+            last[baseline] = index;
+            writeIndex(dst, i, byteStride, index);
+        }
+        return data == dataEnd;
+    }
+
+    // ---- filters ----
+
+    template <typename T>
+    static void octahedralFilter(uint8_t* data, size_t count) {
+        const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; ++i, data += 4 * sizeof(T)) {
+            T v[4];
+            std::memcpy(v, data, sizeof(v));
+            // z由x、y和第三个分量（编码了1.0）还原
+            float x = float(v[0]);
+            float y = float(v[1]);
+            float z = float(v[2]) - std::fabs(x) - std::fabs(y);
+
+            // z<0时折回下半球
+            float t = z < 0.f ? z : 0.f;
+            x += x >= 0.f ? t : -t;
+            y += y >= 0.f ? t : -t;
+
+            float s = max / std::sqrt(x * x + y * y + z * z);
+            v[0] = T(int(x * s + (x >= 0.f ? 0.5f : -0.5f)));
+            v[1] = T(int(y * s + (y >= 0.f ? 0.5f : -0.5f)));
+            v[2] = T(int(z * s + (z >= 0.f ? 0.5f : -0.5f)));
+            std::memcpy(data, v, sizeof(v));
+        }
+    }
+
+    void meshoptOctahedralFilter(uint8_t* data, size_t count, size_t byteStride) {
+        if (byteStride == 4) {
+            octahedralFilter<int8_t>(data, count);
+        } else {
+            octahedralFilter<int16_t>(data, count);
+        }
+    }
+
+    void meshoptQuaternionFilter(uint8_t* data, size_t count, size_t) {
+        const float scale = 1.f / std::sqrt(2.f);
+        for (size_t i = 0; i < count; ++i, data += 8) {
+            int16_t v[4];
+            std::memcpy(v, data, sizeof(v));
+            // 第四个分量：高位是量化比例，低2位是省略的（最大）分量的序号
+            float ss = scale / float(v[3] | 3);
+            float x = float(v[0]) * ss;
+            float y = float(v[1]) * ss;
+            float z = float(v[2]) * ss;
+            float ww = 1.f - x * x - y * y - z * z;
+            float w = std::sqrt(ww >= 0.f ? ww : 0.f);
+
+            int qc = v[3] & 3;
+            int16_t out[4];
+            out[(qc + 1) & 3] = int16_t(int(x * 32767.f + (x >= 0.f ? 0.5f : -0.5f)));
+            out[(qc + 2) & 3] = int16_t(int(y * 32767.f + (y >= 0.f ? 0.5f : -0.5f)));
+            out[(qc + 3) & 3] = int16_t(int(z * 32767.f + (z >= 0.f ? 0.5f : -0.5f)));
+            out[(qc + 0) & 3] = int16_t(int(w * 32767.f + 0.5f));
+            std::memcpy(data, out, sizeof(out));
+        }
+    }
+
+    void meshoptExponentialFilter(uint8_t* data, size_t count, size_t byteStride) {
+        for (size_t i = 0; i < count * byteStride / 4; ++i, data += 4) {
+            uint32_t v;
+            std::memcpy(&v, data, 4);
+            // 低24位有符号尾数m，高8位有符号指数e：m * 2^e
+            int32_t m = int32_t(v << 8) >> 8;
+            int32_t e = int32_t(v) >> 24;
+            float f = std::ldexp(float(m), e);
+            std::memcpy(data, &f, 4);
+        }
+    }
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gltf {
+
+    /**
+     * @brief EXT_meshopt_compression的解码器
+     *  Written against the bitstream description in the extension's spec
+     *  (Appendix A).  Every decoder reads exactly `length` bytes of `src`
+     *  and writes `count` elements of `byteStride` bytes to `dst`.
+     *
+     * @return false if the stream is truncated, has trailing bytes or an
+     *  unknown header
+     */
+
+    // ATTRIBUTES：按字节分组的差分编码，byteStride为4的倍数且不超过256
+    bool decodeMeshoptVertices(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length);
+
+    // TRIANGLES：基于边/顶点FIFO的三角形索引编码，byteStride为2或4，count为3的倍数
+    bool decodeMeshoptTriangles(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length);
+
+    // INDICES：按差分+varint编码的索引序列，byteStride为2或4
+    bool decodeMeshoptIndices(uint8_t* dst, size_t count, size_t byteStride, const uint8_t* src, size_t length);
+
+    // ATTRIBUTES解码后的过滤器，原地作用于count个元素
+    // OCTAHEDRAL：byteStride为4（int8）或8（int16）的八面体编码单位向量
+    void meshoptOctahedralFilter(uint8_t* data, size_t count, size_t byteStride);
+    // QUATERNION：byteStride为8，int16的三分量+最大分量序号编码的单位四元数
+    void meshoptQuaternionFilter(uint8_t* data, size_t count, size_t byteStride);
+    // EXPONENTIAL：24位尾数+8位指数编码的float，byteStride为4的倍数
+    void meshoptExponentialFilter(uint8_t* data, size_t count, size_t byteStride);
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for the nodes of one tree.  Objects are constructed in
+// blocks of `block_size` and never freed one at a time: the whole arena is
+// destroyed at once by `clear` or the destructor, so a tree is torn down
+// without walking it.  An arena is not locked; threads building parts of a
+// tree at the same time each fill an arena of their own and `splice` them
+// together afterwards.
+template <typename T, std::size_t block_size = 1024> class Arena {
+  public:
+    Arena() = default;
+    ~Arena() { this->clear(); }
+
+    // Nodes point at each other, so copying the storage would leave the
+    // copy pointing into this arena; owners copy their trees node by node.
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+    // Moving keeps every object at its address
+    Arena(Arena &&rhs) noexcept { this->swap(rhs); }
+    Arena &operator=(Arena &&rhs) noexcept {
+        if (this != &rhs) {
+            this->clear();
+            this->swap(rhs);
+        }
+        return *this;
+    }
+
+    // Constructs a T from `args` and returns its address, which stays
+    // valid until the arena is cleared or destroyed.
+    template <typename... Args> T *make(Args &&...args) {
+        if (this->blocks.empty() || this->blocks.back().used == block_size) {
+            // Room for the new block is reserved (geometrically) before it
+            // is allocated, so that storing it can't throw and leak it
+            if (this->blocks.size() == this->blocks.capacity()) {
+                this->blocks.reserve(
+                    std::max<std::size_t>(8, 2 * this->blocks.size()));
+            }
+            this->blocks.push_back(Block{
+                static_cast<T *>(::operator new(
+                    sizeof(T) * block_size, std::align_val_t{alignof(T)})),
+                0});
+        }
+        // Counted only once constructed, so `clear` never destroys a slot
+        // whose constructor threw
+        Block &b   = this->blocks.back();
+        T     *ret = new (b.data + b.used) T(std::forward<Args>(args)...);
+        ++b.used;
+        return ret;
+    }
+
+    // Takes over every object of `rhs`, which is left empty.  Objects keep
+    // their addresses.  The blocks of `rhs` go before this arena's last
+    // block, so `make` keeps filling that one.
+    void splice(Arena &rhs) {
+        if (this->blocks.empty()) {
+            this->swap(rhs);
+            return;
+        }
+        this->blocks.insert(this->blocks.end() - 1, rhs.blocks.begin(),
+                            rhs.blocks.end());
+        rhs.blocks.clear();
+    }
+
+    // Destroys every object and releases the memory
+    void clear() {
+        for (Block const &b : this->blocks) {
+            for (std::size_t i = 0; i < b.used; ++i) {
+                b.data[i].~T();
+            }
+            ::operator delete(b.data, std::align_val_t{alignof(T)});
+        }
+        this->blocks.clear();
+    }
+
+    // Number of objects constructed
+    std::size_t size() const {
+        std::size_t ret = 0;
+        for (Block const &b : this->blocks) {
+            ret += b.used;
+        }
+        return ret;
+    }
+
+    void swap(Arena &rhs) noexcept { this->blocks.swap(rhs.blocks); }
+
+  private:
+    struct Block {
+        T *data;
+        // Objects constructed in this block, all of it but for the last
+        // block and blocks taken over by `splice`
+        std::size_t used;
+    };
+    std::vector<Block> blocks;
+};
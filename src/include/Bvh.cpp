@@ -0,0 +1,259 @@
+#include "Bvh.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+// Number of SAH bins per axis
+static size_t constexpr nbins = 16;
+// Ranges this small always become leaves
+static size_t constexpr min_leaf = 4;
+// Ranges larger than this are split even if the SAH prefers a leaf
+static size_t constexpr max_leaf = 32;
+// Cost of visiting a node (projecting its 8 corners), relative to the cost
+// of culling one triangle
+static flt constexpr traversal_cost = 2;
+// Subtrees with fewer triangles are built on the calling thread
+static size_t constexpr parallel_cutoff = 4096;
+// Ranges with more triangles are binned in parallel chunks
+static size_t constexpr parallel_binning = 1 << 16;
+
+namespace {
+
+struct Bin {
+    BBox   bounds;
+    size_t count = 0;
+};
+using Bins = std::array<std::array<Bin, nbins>, 3>;
+
+// Per-triangle data used while building
+struct BuildInput {
+    std::vector<BBox> const &boxes;
+    std::vector<vec3> const &centroids;
+    std::vector<uint32_t>   &order;
+};
+
+// Maps centroids to bins inside the centroid bounds of a range
+struct Binning {
+    vec3 lo{0};
+    // Bins per unit length, zero along flat axes
+    vec3 scale{0};
+
+    Binning() = default;
+    explicit Binning(BBox const &cbounds) : lo{cbounds.minp} {
+        for (int axis = 0; axis < 3; ++axis) {
+            flt const w = cbounds.maxp[axis] - cbounds.minp[axis];
+            this->scale[axis] = w > 0 ? nbins / w : 0;
+        }
+    }
+
+    bool flat(int const &axis) const { return this->scale[axis] == 0; }
+    size_t operator()(vec3 const &c, int const &axis) const {
+        return std::min(nbins - 1,
+                        static_cast<size_t>((c[axis] - this->lo[axis]) *
+                                            this->scale[axis]));
+    }
+};
+
+// Where a range is split
+struct Split {
+    int     axis = -1;
+    size_t  bin;
+    Binning binning;
+};
+
+// Same as `a |= b`, but inlined: this is the builder's inner loop
+inline void grow(BBox &a, BBox const &b) {
+    a.minp = glm::min(a.minp, b.minp);
+    a.maxp = glm::max(a.maxp, b.maxp);
+}
+inline void grow(BBox &a, vec3 const &p) {
+    a.minp = glm::min(a.minp, p);
+    a.maxp = glm::max(a.maxp, p);
+}
+
+// Bounds and centroid bounds of order[begin, end)
+void range_bounds(BuildInput const &in, size_t const &begin,
+                  size_t const &end, BBox &bounds, BBox &cbounds) {
+    for (size_t i = begin; i < end; ++i) {
+        grow(bounds, in.boxes[in.order[i]]);
+        grow(cbounds, in.centroids[in.order[i]]);
+    }
+}
+
+void bin_range(BuildInput const &in, size_t const &begin, size_t const &end,
+               Binning const &binning, Bins &bins) {
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t const t = in.order[i];
+        for (int axis = 0; axis < 3; ++axis) {
+            if (binning.flat(axis)) {
+                continue;
+            }
+            Bin &b = bins[axis][binning(in.centroids[t], axis)];
+            grow(b.bounds, in.boxes[t]);
+            ++b.count;
+        }
+    }
+}
+
+// Calls `body(lo, hi)` over fixed chunks of [begin, end) in parallel and
+// returns one result per chunk, so that merging them in order gives the
+// same answer for any number of threads.
+template <typename T, typename F>
+std::vector<T> chunked(size_t const &begin, size_t const &end, F const &body) {
+    size_t const   nchunks = (end - begin + parallel_binning - 1) / parallel_binning;
+    std::vector<T> ret(nchunks);
+    ThreadPool::global().parallel_for(0, nchunks, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            body(begin + c * parallel_binning,
+                 std::min(end, begin + (c + 1) * parallel_binning), ret[c]);
+        }
+    });
+    return ret;
+}
+
+// Chooses the cheapest binned SAH split of order[begin, end), whose
+// triangles' bounds are `bounds`.  Returns no axis when a leaf is cheaper.
+Split find_split(BuildInput const &in, size_t const &begin, size_t const &end,
+                 BBox &bounds) {
+    Split  ret;
+    size_t n = end - begin;
+    BBox   cbounds;
+    Bins   bins;
+    if (n > parallel_binning) {
+        using Pair = std::pair<BBox, BBox>;
+        for (Pair const &p : chunked<Pair>(
+                 begin, end, [&](size_t lo, size_t hi, Pair &out) {
+                     range_bounds(in, lo, hi, out.first, out.second);
+                 })) {
+            grow(bounds, p.first);
+            grow(cbounds, p.second);
+        }
+        ret.binning = Binning{cbounds};
+        for (Bins const &part : chunked<Bins>(
+                 begin, end, [&](size_t lo, size_t hi, Bins &out) {
+                     bin_range(in, lo, hi, ret.binning, out);
+                 })) {
+            for (int axis = 0; axis < 3; ++axis) {
+                for (size_t b = 0; b < nbins; ++b) {
+                    grow(bins[axis][b].bounds, part[axis][b].bounds);
+                    bins[axis][b].count += part[axis][b].count;
+                }
+            }
+        }
+    } else {
+        range_bounds(in, begin, end, bounds, cbounds);
+        if (n <= min_leaf) {
+            return ret;
+        }
+        ret.binning = Binning{cbounds};
+        bin_range(in, begin, end, ret.binning, bins);
+    }
+
+    // Sweep the bins from both sides; a leaf costs one test per triangle.
+    // Degenerate (zero area) bounds make every split cost the same.
+    flt const inv_area = bounds.area() > 0 ? 1 / bounds.area() : 0;
+    flt       best     = n;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (ret.binning.flat(axis)) {
+            continue;
+        }
+        std::array<flt, nbins> right_cost;
+        BBox                   acc;
+        size_t                 count = 0;
+        for (size_t b = nbins - 1; b > 0; --b) {
+            grow(acc, bins[axis][b].bounds);
+            count += bins[axis][b].count;
+            right_cost[b] = count == 0 ? 0 : acc.area() * count;
+        }
+        acc   = BBox{};
+        count = 0;
+        for (size_t b = 0; b + 1 < nbins; ++b) {
+            grow(acc, bins[axis][b].bounds);
+            count += bins[axis][b].count;
+            if (count == 0 || count == n) {
+                continue;
+            }
+            flt const cost =
+                traversal_cost +
+                (acc.area() * count + right_cost[b + 1]) * inv_area;
+            if (cost < best || (ret.axis < 0 && n > max_leaf)) {
+                best     = cost;
+                ret.axis = axis;
+                ret.bin  = b;
+            }
+        }
+    }
+    return ret;
+}
+
+// Builds the subtree over order[begin, end) into `nodes`, with node
+// indices relative to the subtree root, which is nodes[0].
+void build_range(BuildInput const &in, size_t const &begin, size_t const &end,
+                 std::vector<Bvh::Node> &nodes) {
+    size_t const self = nodes.size();
+    nodes.push_back(Bvh::Node{BBox{}, static_cast<uint32_t>(begin),
+                              static_cast<uint32_t>(end), 0});
+    BBox        bounds;
+    Split const split = find_split(in, begin, end, bounds);
+    nodes[self].bounds = bounds;
+    if (split.axis < 0) {
+        return;
+    }
+    size_t const mid =
+        std::partition(in.order.begin() + begin, in.order.begin() + end,
+                       [&](uint32_t t) {
+                           return split.binning(in.centroids[t], split.axis) <=
+                                  split.bin;
+                       }) -
+        in.order.begin();
+    if (end - begin < parallel_cutoff) {
+        build_range(in, begin, mid, nodes);
+        nodes[self].second = static_cast<uint32_t>(nodes.size());
+        build_range(in, mid, end, nodes);
+        return;
+    }
+    // Both halves at once, each into its own array, then spliced after
+    // this node with their indices shifted
+    std::array<std::vector<Bvh::Node>, 2> sub;
+    ThreadPool::global().parallel_for(0, 2, 1, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; ++k) {
+            build_range(in, k == 0 ? begin : mid, k == 0 ? mid : end, sub[k]);
+        }
+    });
+    for (std::vector<Bvh::Node> const &part : sub) {
+        uint32_t const offset = static_cast<uint32_t>(nodes.size());
+        if (&part == &sub[1]) {
+            nodes[self].second = offset;
+        }
+        for (Bvh::Node node : part) {
+            if (!node.isleaf()) {
+                node.second += offset;
+            }
+            nodes.push_back(node);
+        }
+    }
+}
+
+} // namespace
+
+void Bvh::build(std::vector<Triangle> const &triangles) {
+    this->nodes.clear();
+    this->order.clear();
+    size_t const n = triangles.size();
+    if (n == 0) {
+        return;
+    }
+    std::vector<BBox> boxes(n);
+    std::vector<vec3> centroids(n);
+    ThreadPool::global().parallel_for(0, n, 4096, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            boxes[i]     = triangles[i].boundingbox();
+            centroids[i] = boxes[i].centroid();
+        }
+    });
+    this->order.resize(n);
+    std::iota(this->order.begin(), this->order.end(), 0);
+    build_range(BuildInput{boxes, centroids, this->order}, 0, n, this->nodes);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Triangle.hpp"
+#include "global.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a geometry's triangles, split with the
+// surface area heuristic (SAH).
+//
+// Every node is split in two where the binned SAH cost is lowest, so node
+// boxes follow the triangles instead of a fixed grid, and each triangle
+// ends up in exactly one leaf.  Nodes are stored depth-first: the first
+// child of an internal node immediately follows it.
+struct Bvh {
+    struct Node {
+        // Bounds of the node's triangles
+        BBox bounds;
+        // The node's triangles are positions [begin, end) of `order` (see
+        // `triangle`), those of its whole subtree for internal nodes.
+        uint32_t begin;
+        uint32_t end;
+        // Index of the second child; the first one is the next node.  Zero
+        // for leaves, since the root can't be anyone's child.
+        uint32_t second;
+
+        bool isleaf() const { return this->second == 0; }
+    };
+
+    // Depth-first, the root is nodes[0].  Empty for no triangles.
+    std::vector<Node> nodes;
+    // Positions in Geometry::triangles, in leaf order.  Empty when
+    // Geometry::triangles itself is stored in leaf order.
+    std::vector<uint32_t> order;
+
+    // Builds the tree over `triangles`.  Subtrees are built concurrently on
+    // the global thread pool; the result does not depend on the number of
+    // threads.
+    void build(std::vector<Triangle> const &triangles);
+
+    bool empty() const { return this->nodes.empty(); }
+
+    // Position in Geometry::triangles of the i-th triangle in leaf order
+    size_t triangle(size_t const &i) const {
+        return this->order.empty() ? i : this->order[i];
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "global.hpp"
+
+#include <array>
+
+// View frustum of a model-view-projection matrix, as 6 planes in the
+// model's space.  A point lies inside when it lands in the canonical cube
+// $[-1, 1]^3$ and in front of the camera, i.e. on the inner side of all
+// planes.
+struct Frustum {
+    // Bit `i` set: a box is known to lie entirely on the inner side of
+    // plane `i`, so its descendants need not test that plane again.
+    using Mask = unsigned;
+    static Mask constexpr inside = 0x3f;
+
+    Frustum() = default;
+    // `front` is any non-zero value with the sign that the w coordinate of
+    // `homo * mvp` has in front of the camera.
+    Frustum(mat4 const &mvp, flt const &front) {
+        // Homogeneous coordinates are `homo * mvp`, so component `k` is
+        // dot(homo, mvp[k]); in front of the camera -|w| <= x, y, z <= |w|.
+        flt const s = front > 0 ? 1 : -1;
+        for (int k = 0; k < 3; ++k) {
+            this->planes[2 * k]     = s * (mvp[3] + mvp[k]);
+            this->planes[2 * k + 1] = s * (mvp[3] - mvp[k]);
+        }
+    }
+
+    // Tests box `b` against the planes not yet set in `mask`, with the
+    // p/n-vertex trick: only the corner farthest along a plane's normal can
+    // be inside it, and only the nearest one can be outside.  Returns false
+    // when `b` is entirely outside some plane; otherwise adds to `mask` the
+    // planes `b` is entirely inside of.  Conservative: a box near a corner
+    // of the frustum may pass although it misses it.
+    bool intersects(BBox const &b, Mask &mask) const {
+        for (int i = 0; i < 6; ++i) {
+            if (mask >> i & 1) {
+                continue;
+            }
+            vec4 const &p = this->planes[i];
+            vec3 const  pv{p.x >= 0 ? b.maxp.x : b.minp.x,
+                           p.y >= 0 ? b.maxp.y : b.minp.y,
+                           p.z >= 0 ? b.maxp.z : b.minp.z};
+            if (glm::dot(vec3(p), pv) + p.w < 0) {
+                return false;
+            }
+            vec3 const  nv{p.x >= 0 ? b.minp.x : b.maxp.x,
+                           p.y >= 0 ? b.minp.y : b.maxp.y,
+                           p.z >= 0 ? b.minp.z : b.maxp.z};
+            if (glm::dot(vec3(p), nv) + p.w >= 0) {
+                mask |= 1u << i;
+            }
+        }
+        return true;
+    }
+
+    std::array<vec4, 6> planes;
+};
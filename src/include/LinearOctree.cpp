@@ -0,0 +1,201 @@
+#include "LinearOctree.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+// Bits per axis of a Morton code, 3 * 21 = 63 bits in total
+static int constexpr morton_bits = 21;
+// Same threshold as the pointer octree: fewer triangles make a leaf
+static size_t constexpr leaf_size = 24;
+
+// Spreads the lowest 21 bits of `v` so that there are two zero bits
+// between every two of them.
+static uint64_t expand_bits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+// Splits [begin, end) of the global pool's range into chunks of at least
+// `grain` elements, one task per chunk.
+static void parallel_for(size_t const &begin, size_t const &end,
+                         size_t const &grain,
+                         std::function<void(size_t, size_t)> const &body) {
+    ThreadPool &pool = ThreadPool::global();
+    size_t chunk = std::max(grain, (end - begin) / (pool.size() * 4) + 1);
+    pool.parallel_for(begin, end, chunk, body);
+}
+
+// Stable LSD radix sort of `codes` (carrying `index` along), 8 bits per
+// pass.  Each pass histograms fixed chunks of the input in parallel, then
+// every chunk scatters its elements to offsets computed from the
+// histograms, so the result does not depend on the number of threads.
+static void radix_sort(std::vector<uint64_t> &codes,
+                       std::vector<uint32_t> &index) {
+    size_t const          n       = codes.size();
+    size_t const          nchunks = std::min<size_t>(
+        n / 4096 + 1, ThreadPool::global().size() * 4);
+    size_t const          chunk   = (n + nchunks - 1) / nchunks;
+    std::vector<uint64_t> codes_out(n);
+    std::vector<uint32_t> index_out(n);
+    std::vector<std::array<size_t, 256>> offsets(nchunks);
+    for (int shift = 0; shift < 3 * morton_bits; shift += 8) {
+        ThreadPool::global().parallel_for(
+            0, nchunks, 1, [&](size_t lo, size_t hi) {
+                for (size_t c = lo; c < hi; ++c) {
+                    offsets[c].fill(0);
+                    for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk);
+                         ++i) {
+                        ++offsets[c][(codes[i] >> shift) & 0xff];
+                    }
+                }
+            });
+        // Exclusive prefix sum in (digit, chunk) order
+        size_t sum = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            for (size_t c = 0; c < nchunks; ++c) {
+                size_t const count = offsets[c][d];
+                offsets[c][d]      = sum;
+                sum += count;
+            }
+        }
+        ThreadPool::global().parallel_for(
+            0, nchunks, 1, [&](size_t lo, size_t hi) {
+                for (size_t c = lo; c < hi; ++c) {
+                    for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk);
+                         ++i) {
+                        size_t const p = offsets[c][(codes[i] >> shift) & 0xff]++;
+                        codes_out[p]   = codes[i];
+                        index_out[p]   = index[i];
+                    }
+                }
+            });
+        codes.swap(codes_out);
+        index.swap(index_out);
+    }
+}
+
+void LinearOctree::build(std::vector<Triangle> const &triangles,
+                         BBox const                  &bbox) {
+    this->nodes.clear();
+    this->order.clear();
+    size_t const n = triangles.size();
+    if (n == 0) {
+        return;
+    }
+
+    // 1. Morton codes of the centroids, quantized inside `bbox`
+    std::vector<uint64_t> codes(n);
+    this->order.resize(n);
+    std::iota(this->order.begin(), this->order.end(), 0);
+    flt const scale = (1 << morton_bits) - 1;
+    vec3 const extent = bbox.extent();
+    vec3 const inv{extent.x > 0 ? scale / extent.x : 0,
+                   extent.y > 0 ? scale / extent.y : 0,
+                   extent.z > 0 ? scale / extent.z : 0};
+    parallel_for(0, n, 4096, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            Triangle const &t = triangles[i];
+            vec3 const q = ((t.a() + t.b() + t.c()) / 3.0 - bbox.minp) * inv;
+            uint64_t   cell[3];
+            for (int k = 0; k < 3; ++k) {
+                cell[k] = static_cast<uint64_t>(clamp<flt>(q[k], 0, scale));
+            }
+            codes[i] = expand_bits(cell[0]) | expand_bits(cell[1]) << 1 |
+                       expand_bits(cell[2]) << 2;
+        }
+    });
+
+    // 2. Sort the triangles by code
+    radix_sort(codes, this->order);
+
+    // 3. Emit nodes level by level.  A node at depth `d` splits its range
+    //    on bits [3 * (20 - d), 3 * (20 - d) + 3) of the codes; since the
+    //    range is sorted and shares all higher bits, each child's range is
+    //    found by binary search.  Chains of single children are skipped.
+    std::vector<int>    depth{0};
+    std::vector<size_t> level_begin{0};
+    this->nodes.push_back(Node{BBox{}, 0, static_cast<uint32_t>(n), 0, 0});
+    for (size_t first = 0, last = 1; first < last;
+         first = last, last = this->nodes.size()) {
+        level_begin.push_back(last);
+        std::vector<std::array<uint32_t, 9>> split(last - first);
+        std::vector<int>                     split_depth(last - first);
+        parallel_for(first, last, 64, [&](size_t lo, size_t hi) {
+            for (size_t k = lo; k < hi; ++k) {
+                Node const &node = this->nodes[k];
+                int         d    = depth[k];
+                auto       &s    = split[k - first];
+                s.fill(node.begin);
+                if (node.end - node.begin < leaf_size) {
+                    split_depth[k - first] = -1;
+                    continue;
+                }
+                for (; d < morton_bits; ++d) {
+                    // More than one non-empty child: split here
+                    int const shift = 3 * (morton_bits - 1 - d);
+                    if ((codes[node.begin] >> shift & 7) !=
+                        (codes[node.end - 1] >> shift & 7)) {
+                        break;
+                    }
+                }
+                // All triangles share one Morton cell: keep them in a leaf
+                if (d == morton_bits) {
+                    split_depth[k - first] = -1;
+                    continue;
+                }
+                int const shift = 3 * (morton_bits - 1 - d);
+                for (uint32_t c = 0; c < 8; ++c) {
+                    s[c + 1] = static_cast<uint32_t>(
+                        std::partition_point(
+                            codes.begin() + s[c], codes.begin() + node.end,
+                            [&](uint64_t code) { return (code >> shift & 7) <= c; }) -
+                        codes.begin());
+                }
+                split_depth[k - first] = d;
+            }
+        });
+        // Children of this level, appended in order
+        for (size_t k = first; k < last; ++k) {
+            auto const &s = split[k - first];
+            if (split_depth[k - first] < 0) {
+                continue;
+            }
+            this->nodes[k].first_child = static_cast<uint32_t>(this->nodes.size());
+            for (int c = 0; c < 8; ++c) {
+                if (s[c] == s[c + 1]) {
+                    continue;
+                }
+                this->nodes.push_back(Node{BBox{}, s[c], s[c + 1], 0, 0});
+                depth.push_back(split_depth[k - first] + 1);
+                ++this->nodes[k].nchildren;
+            }
+        }
+    }
+
+    // 4. Bounds bottom-up, one level at a time
+    for (size_t l = level_begin.size() - 1; l-- > 0;) {
+        parallel_for(level_begin[l], level_begin[l + 1], 64,
+                     [&](size_t lo, size_t hi) {
+                         for (size_t k = lo; k < hi; ++k) {
+                             Node &node = this->nodes[k];
+                             if (node.nchildren == 0) {
+                                 for (uint32_t i = node.begin; i < node.end; ++i) {
+                                     node.bounds |=
+                                         triangles[this->order[i]].boundingbox();
+                                 }
+                             }
+                             for (uint32_t c = 0; c < node.nchildren; ++c) {
+                                 node.bounds |=
+                                     this->nodes[node.first_child + c].bounds;
+                             }
+                         }
+                     });
+    }
+}
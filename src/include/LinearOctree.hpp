@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Triangle.hpp"
+#include "global.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Octree over a geometry's triangles without any pointers, built from the
+// Morton codes of the triangles' centroids.
+//
+// Triangles are sorted by Morton code (a parallel radix sort), so the
+// triangles of every octree cell form one contiguous range of the sorted
+// order.  Nodes live in one array in breadth-first order, the children of
+// a node are consecutive, and a node only stores its range and where its
+// children start.  A triangle belongs to the cell of its centroid, so
+// nothing piles up in internal nodes: only leaves own triangles.
+struct LinearOctree {
+    struct Node {
+        // Bounds of the node's triangles.  Not the node's Morton cell:
+        // triangles are placed by their centroid and may stick out of it.
+        BBox bounds;
+        // The node's triangles are positions [begin, end) of the sorted
+        // order (see `triangle`), those of its whole subtree for internal
+        // nodes.
+        uint32_t begin;
+        uint32_t end;
+        // Children are `nodes[first_child, first_child + nchildren)`, in
+        // octant order (same numbering as Node8::index).  Leaves have none.
+        uint32_t first_child;
+        uint32_t nchildren;
+    };
+
+    // Breadth-first, the root is nodes[0].  Empty for no triangles.
+    std::vector<Node> nodes;
+    // Positions in Geometry::triangles, sorted by Morton code.  Empty when
+    // Geometry::triangles itself is stored in Morton order.
+    std::vector<uint32_t> order;
+
+    // Builds the tree over `triangles`, all of which lie inside `bbox`.
+    // Runs on the global thread pool.
+    void build(std::vector<Triangle> const &triangles, BBox const &bbox);
+
+    bool empty() const { return this->nodes.empty(); }
+
+    // Position in Geometry::triangles of the i-th triangle in Morton order
+    size_t triangle(size_t const &i) const {
+        return this->order.empty() ? i : this->order[i];
+    }
+};
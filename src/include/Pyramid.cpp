@@ -2,12 +2,40 @@
 
 #include <cassert>
 
-Pyramid::Pyramid() {}
+Pyramid::Pyramid() : h{0}, w{0}, root{nullptr} {}
 Pyramid::Pyramid(size_t const &height, size_t const &width)
-    : h{height}, w{width} {
+    : h{height}, w{width}, root{nullptr} {
     this->nodes.resize(this->h * this->w, nullptr);
     this->construct();
 }
+Pyramid::Pyramid(Pyramid const &rhs) : Pyramid() {
+    if (rhs.root == nullptr) {
+        return;
+    }
+    Pyramid{rhs.h, rhs.w}.swap(*this);
+    copy_depths(this->root, rhs.root);
+}
+Pyramid &Pyramid::operator=(Pyramid const &rhs) {
+    if (this != &rhs) {
+        Pyramid{rhs}.swap(*this);
+    }
+    return *this;
+}
+Pyramid::Pyramid(Pyramid &&rhs) noexcept : Pyramid() { this->swap(rhs); }
+Pyramid &Pyramid::operator=(Pyramid &&rhs) noexcept {
+    // The old tree is freed with `tmp`
+    Pyramid tmp{std::move(rhs)};
+    this->swap(tmp);
+    return *this;
+}
+
+void Pyramid::swap(Pyramid &rhs) noexcept {
+    std::swap(this->h, rhs.h);
+    std::swap(this->w, rhs.w);
+    this->nodes.swap(rhs.nodes);
+    this->arena.swap(rhs.arena);
+    std::swap(this->root, rhs.root);
+}
 
 flt &Pyramid::operator()(size_t const &x, size_t const &y) {
     return this->nodes[this->w * y + x]->depth;
@@ -20,7 +48,11 @@ void Pyramid::construct() {
     pss southwestern = std::make_pair(0, 0);
     pss northeastern = std::make_pair(this->w, this->h);
     debugm("Constructing depth buffer MIP-map ..\n");
+    this->arena.clear();
     this->root = build(southwestern, northeastern, nullptr);
+    if (this->root == nullptr) {
+        return;
+    }
     this->update_tdep(this->root);
     msg("Hierarchical depth buffer constructed\n");
 }
@@ -136,6 +168,15 @@ Node4 *Pyramid::which(int x, int y, Node4 *node) const {
     return this->nodes[y * this->w + x];
 }
 
+void Pyramid::copy_depths(Node4 *dst, Node4 const *src) {
+    dst->depth = src->depth;
+    for (size_t i = 0; i < 4; ++i) {
+        if (src->children[i] != nullptr) {
+            copy_depths(dst->children[i], src->children[i]);
+        }
+    }
+}
+
 Node4 *const Pyramid::build(pss const &sw, pss const &ne, Node4 *const fa) {
     int x1 = sw.first, y1 = sw.second;
     int x2 = ne.first, y2 = ne.second;
@@ -143,7 +184,7 @@ Node4 *const Pyramid::build(pss const &sw, pss const &ne, Node4 *const fa) {
         // Can't divide in either of x or y dimention.
         return nullptr;
     }
-    Node4 *ret = new Node4;
+    Node4 *ret = this->arena.make();
     ret->fa    = fa;
     ret->sw    = sw;
     ret->ne    = ne;
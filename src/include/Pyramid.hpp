@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Arena.hpp"
 #include "Triangle.hpp"
 #include "global.hpp"
 
@@ -52,6 +53,8 @@ class Pyramid {
 
     // Leaf nodes, containing finest depth values
     std::vector<Node4 *> nodes;
+    // Storage of every node of the tree, released all at once
+    Arena<Node4, 4096> arena;
 
   private:
     // Helper functions
@@ -68,6 +71,8 @@ class Pyramid {
     // Leaf node corresponding to image coordinate (x, y), pass this->root to
     // the 3rd parameter.
     Node4 *which(int x, int y, Node4 *node) const;
+    // Copies the depth values of the subtree rooted at `src` (same shape)
+    static void copy_depths(Node4 *dst, Node4 const *src);
 
   public:
     // Root of depth MIP-map
@@ -76,6 +81,14 @@ class Pyramid {
   public:
     Pyramid();
     Pyramid(size_t const &height, size_t const &width);
+    // Copies build a tree of their own with the same depth values
+    Pyramid(Pyramid const &rhs);
+    Pyramid &operator=(Pyramid const &rhs);
+    // Moves take over the tree, leaving `rhs` empty
+    Pyramid(Pyramid &&rhs) noexcept;
+    Pyramid &operator=(Pyramid &&rhs) noexcept;
+
+    void swap(Pyramid &rhs) noexcept;
 
     // Frontend for MIP-map construction.
     void construct();
@@ -1,14 +1,40 @@
 #include "Scene.hpp"
+#include "ThreadPool.hpp"
 #include "global.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <limits>
+#include <numeric>
+
+// Moves `items[order[i]]` to position `i`, following the cycles of the
+// permutation so that nothing but one element is held aside.  `order` is
+// consumed.
+template <typename T>
+static void apply_order(std::vector<T> &items, std::vector<uint32_t> &order) {
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] == i) {
+            continue;
+        }
+        T      held = std::move(items[i]);
+        size_t j    = i;
+        while (order[j] != i) {
+            size_t const k = order[j];
+            items[j]       = std::move(items[k]);
+            order[j]       = j;
+            j              = k;
+        }
+        items[j] = std::move(held);
+        order[j] = j;
+    }
+}
 
 Scene::Scene() { this->_init(); }
 Scene::Scene(objl::Mesh const &mesh) {
     this->_init();
     msg("%lu vertices found in loaded mesh\n", mesh.Vertices.size());
+    std::vector<Triangle> triangles;
     // 顶点的顺序是按照索引 保存的？
     for (size_t i = 0; i < mesh.Vertices.size(); i += 3) {
         std::array<vec3, 3> verts;
@@ -30,11 +56,12 @@ Scene::Scene(objl::Mesh const &mesh) {
         Triangle tri(verts[0], verts[1], verts[2], indices[0], indices[1], indices[2]);
         tri.meshName = "" ;  // 加入meshname
     //       this->realworld_triangles.emplace_back(verts[0], verts[1], verts[2]); 
-        this->realworld_triangles.emplace_back(tri);  // 改6、
-        printf("%d\n",realworld_triangles.size());
+        triangles.emplace_back(tri);  // 改6、
+        printf("%d\n",triangles.size());
     }
-    msg("Scene created with %lu triangles\n", realworld_triangles.size());
-    this->_build_octree();
+    msg("Scene created with %lu triangles\n", triangles.size());
+    this->add_instance(this->_add_geometry(std::move(triangles)),
+                       glm::identity<mat4>());
 }
 
 // 20220211 add
@@ -43,7 +70,7 @@ Scene::Scene(objl::Mesh const &mesh,std::vector<int> meshLength,std::vector<std:
     msg("%lu vertices found in loaded mesh\n", mesh.Vertices.size());
     int k=0;
     int ll = meshLength[k];
-    int index = 0 ;
+    std::vector<Triangle> triangles;
     ///// 
     std::cout<<" ceshi \n" ;
     for(int i=0;i<meshLength.size();i++){
@@ -70,23 +97,272 @@ Scene::Scene(objl::Mesh const &mesh,std::vector<int> meshLength,std::vector<std:
         // 改4、Triangle的构造函数（triangle.cpp） + 将顶点verts和索引indices传进realworld_triangles
         // Triangle tri = new Triangle(verts[0], verts[1], verts[2]);
         Triangle tri(verts[0], verts[1], verts[2], indices[0], indices[1], indices[2]);
-        tri.indexOfTriangles = index ++;  // 每个三角形在realword_triangle中的索引
         tri.meshName = meshName[k] ;  // 加入meshname
         ll-- ;
         if(ll == 0 && k+1 != meshName.size()){
             ll = meshLength[++k];
         }
-        this->realworld_triangles.emplace_back(tri);  // 改6、
-        //printf("%d\n",realworld_triangles.size());
+        triangles.emplace_back(tri);  // 改6、
+        //printf("%d\n",triangles.size());
     }
-    msg("Scene created with %lu triangles\n", realworld_triangles.size());
-    this->_build_octree();
+    msg("Scene created with %lu triangles\n", triangles.size());
+    this->add_instance(this->_add_geometry(std::move(triangles)),
+                       glm::identity<mat4>());
 }
 
-Scene::Scene(std::vector<Triangle> const &triangles)
-    : realworld_triangles(triangles) {
+Scene::Scene(std::vector<float> const &positions,
+             std::vector<int> const &indices, std::vector<pss> const &ranges,
+             std::vector<FlatOctreeView> const &octrees,
+             HierarchyOptions const            &hierarchy) {
     this->_init();
-    this->_build_octree();
+    this->hierarchy = hierarchy;
+    msg("%lu vertices, %lu indices found in loaded asset\n",
+        positions.size() / 3, indices.size());
+    if (!octrees.empty() && octrees.size() != ranges.size()) {
+        errorm("%zu octrees given for %zu geometries\n", octrees.size(),
+               ranges.size());
+    }
+    size_t ntriangles = 0;
+    for (size_t g = 0; g < ranges.size(); ++g) {
+        pss const            &range = ranges[g];
+        size_t const          n     = range.second / 3;
+        std::vector<Triangle> triangles;
+        triangles.reserve(n);
+        // A given octree fixes the triangles' order, assemble them in that
+        // order right away instead of permuting them afterwards
+        FlatOctreeView const *octree =
+            octrees.empty() ? nullptr : &octrees[g];
+        bool const ordered = octree != nullptr && octree->nprims == n;
+        // Merged while the triangles are assembled, saves another pass
+        BBox bbox;
+        int lo = std::numeric_limits<int>::max(), hi = -1;
+        for (size_t k = 0; k < n; ++k) {
+            size_t const        t = ordered ? octree->prims[k] : k;
+            size_t const        i = range.first + 3 * t;
+            std::array<vec3, 3> verts;
+            for (int j = 0; j < 3; ++j) {
+                float const *p =
+                    &positions[3 * static_cast<size_t>(indices[i + j])];
+                verts[j] = vec3(p[0], p[1], p[2]);
+                bbox |= verts[j];
+                lo       = std::min(lo, indices[i + j]);
+                hi       = std::max(hi, indices[i + j]);
+            }
+            triangles.emplace_back(verts[0], verts[1], verts[2], indices[i],
+                                   indices[i + 1], indices[i + 2]);
+            triangles.back().indexOfTriangles = t;
+        }
+        ntriangles += triangles.size();
+        size_t id = this->_add_geometry(std::move(triangles), &bbox,
+                                        ordered ? octree : nullptr);
+        // The geometry's vertices are the contiguous block its indices
+        // refer to, so each of them can be transformed once per instance.
+        Geometry &geometry = this->geometries[id];
+        if (hi >= lo) {
+            geometry.first = lo;
+            geometry.vertices.reserve(hi - lo + 1);
+            for (int v = lo; v <= hi; ++v) {
+                float const *p = &positions[3 * static_cast<size_t>(v)];
+                geometry.vertices.emplace_back(p[0], p[1], p[2]);
+            }
+        }
+    }
+    msg("Scene created with %lu unique triangles in %lu geometries\n",
+        ntriangles, this->geometries.size());
+}
+
+Scene::Scene(Scene const &rhs)
+    : geometries{rhs.geometries}, instances{rhs.instances},
+      deleted{rhs.deleted}, bounds{rhs.bounds}, hierarchy{rhs.hierarchy},
+      viewspace_triangles{rhs.viewspace_triangles} {
+    for (Geometry &g : this->geometries) {
+        g.root = this->_clone(g.root, nullptr);
+    }
+}
+Scene &Scene::operator=(Scene const &rhs) {
+    if (this != &rhs) {
+        *this = Scene{rhs};
+    }
+    return *this;
+}
+
+Scene::Scene(std::vector<Triangle> const &triangles) {
+    this->_init();
+    this->add_instance(
+        this->_add_geometry(std::vector<Triangle>(triangles)),
+        glm::identity<mat4>());
+}
+
+size_t Scene::add_instance(size_t const &geometry, mat4 const &transform,
+                           std::string const &name) {
+    if (geometry >= this->geometries.size()) {
+        errorm("Instance references geometry %zu, only %zu exist\n",
+               geometry, this->geometries.size());
+    }
+    Geometry const &g = this->geometries[geometry];
+    Instance        inst;
+    inst.geometry  = geometry;
+    inst.transform = transform;
+    inst.first     = this->deleted.size();
+    inst.name      = name;
+    this->deleted.resize(this->deleted.size() + g.triangles.size(), 0);
+
+    // World space bounds from the 8 transformed corners of the local box
+    if (!g.triangles.empty()) {
+        for (int i = 0; i < 8; ++i) {
+            flt  homo_value[] = {i & 1 ? g.bbox.maxp.x : g.bbox.minp.x,
+                                 i & 2 ? g.bbox.maxp.y : g.bbox.minp.y,
+                                 i & 4 ? g.bbox.maxp.z : g.bbox.minp.z, 1};
+            vec4 homo         = glm::make_vec4(homo_value) * transform;
+            inst.bounds |= vec3{homo.x, homo.y, homo.z} / homo.w;
+        }
+        this->bounds |= inst.bounds;
+    }
+    this->instances.push_back(inst);
+    return this->instances.size() - 1;
+}
+
+vec3 Scene::local_gaze(Instance const &instance, vec3 const &gaze) const {
+    // World space positions are `p * A` (A: upper-left 3x3 of the
+    // transform), so world space facings are `facing * det(A) * A^{-T}`
+    // (row vectors).  Testing dot(gaze, that) is the same as testing
+    // dot(gaze * A^{-1} * det(A), facing), and only its sign matters.
+    mat3 a = mat3(instance.transform);
+    flt  d = glm::determinant(a);
+    return gaze * glm::inverse(a) * (d < 0 ? -1.0 : 1.0);
+}
+
+bool Scene::outside_frustum(Instance const &instance, mat4 const &mvp) const {
+    return Scene::outside_frustum(instance.bounds, mvp);
+}
+
+bool Scene::outside_frustum(BBox const &b, mat4 const &mvp) {
+    if (b.minp.x > b.maxp.x) {
+        return true;
+    }
+    // A projective map keeps convexity only on one side of the camera
+    // plane, so the box is tested only when all corners share the sign of w.
+    // Then it is outside iff all corners are beyond the same face of the
+    // canonical box $[-1, 1]^3$.
+    int above[3] = {0, 0, 0}, below[3] = {0, 0, 0}, positive = 0;
+    for (int i = 0; i < 8; ++i) {
+        flt  homo_value[] = {i & 1 ? b.maxp.x : b.minp.x,
+                             i & 2 ? b.maxp.y : b.minp.y,
+                             i & 4 ? b.maxp.z : b.minp.z, 1};
+        vec4 homo         = glm::make_vec4(homo_value) * mvp;
+        positive += homo.w > 0;
+        for (int k = 0; k < 3; ++k) {
+            flt c = homo[k] / homo.w;
+            above[k] += c > 1;
+            below[k] += c < -1;
+        }
+    }
+    if (positive != 0 && positive != 8) {
+        return false;
+    }
+    for (int k = 0; k < 3; ++k) {
+        if (above[k] == 8 || below[k] == 8) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Geometry::project(mat4 const &m, std::vector<vec3> &out) const {
+    out.resize(this->vertices.size());
+    for (size_t i = 0; i < this->vertices.size(); ++i) {
+        vec3 const &v            = this->vertices[i];
+        flt         homo_value[] = {v.x, v.y, v.z, 1};
+        vec4        homo         = glm::make_vec4(homo_value) * m;
+        out[i] = vec3{homo.x / homo.w, homo.y / homo.w, homo.z / homo.w};
+    }
+}
+
+Triangle Geometry::transformed(Triangle const          &t,
+                               std::vector<vec3> const &projected) const {
+    Triangle ret(t);
+    ret.v[0] = projected[t.index_a - this->first];
+    ret.v[1] = projected[t.index_b - this->first];
+    ret.v[2] = projected[t.index_c - this->first];
+    return ret;
+}
+
+bool FlatOctree::valid(size_t ntriangles) const {
+    return FlatOctreeView{*this}.valid(ntriangles);
+}
+
+bool FlatOctreeView::valid(size_t ntriangles) const {
+    if (this->nprims != (this->nnodes == 0 ? 0 : ntriangles)) {
+        return false;
+    }
+    // 每个节点至多被引用一次，否则展开时共享的子树会被重复复制
+    std::vector<bool> has_parent(this->nnodes, false);
+    for (size_t n = 0; n < this->nnodes; ++n) {
+        FlatOctree::Node const &node = this->nodes[n];
+        if (node.first > this->nprims ||
+            node.count > this->nprims - node.first) {
+            return false;
+        }
+        for (int32_t child : node.children) {
+            if (child == -1) {
+                continue;
+            }
+            if (child <= static_cast<int64_t>(n) ||
+                child >= static_cast<int64_t>(this->nnodes) ||
+                has_parent[child]) {
+                return false;
+            }
+            has_parent[child] = true;
+        }
+    }
+    std::vector<bool> seen(ntriangles, false);
+    for (size_t i = 0; i < this->nprims; ++i) {
+        uint32_t const t = this->prims[i];
+        if (t >= ntriangles || seen[t]) {
+            return false;
+        }
+        seen[t] = true;
+    }
+    return true;
+}
+
+FlatOctree Scene::flatten_octree(size_t const &geometry) const {
+    FlatOctree      ret;
+    Geometry const &g = this->geometries[geometry];
+    if (g.root == nullptr) {
+        return ret;
+    }
+    ret.prims.reserve(g.triangles.size());
+    for (Triangle const &t : g.triangles) {
+        ret.prims.push_back(static_cast<uint32_t>(t.indexOfTriangles));
+    }
+    // Pre-order: a node's index is known before its children are visited
+    std::vector<std::pair<Node8 const *, int32_t>> stack{{g.root, -1}};
+    while (!stack.empty()) {
+        auto [node, parent_slot] = stack.back();
+        stack.pop_back();
+        int32_t const index = static_cast<int32_t>(ret.nodes.size());
+        if (parent_slot != -1) {
+            ret.nodes[parent_slot / 8].children[parent_slot % 8] = index;
+        }
+        FlatOctree::Node flat;
+        for (int i = 0; i < 3; ++i) {
+            flat.mincord[i] = node->mincord[i];
+            flat.maxcord[i] = node->maxcord[i];
+        }
+        std::fill(std::begin(flat.children), std::end(flat.children), -1);
+        flat.first   = static_cast<uint32_t>(node->begin);
+        flat.count   = static_cast<uint32_t>(node->end - node->begin);
+        flat.isleaf  = node->isleaf;
+        flat.padding = 0;
+        ret.nodes.push_back(flat);
+        for (int i = 7; i >= 0; --i) {
+            if (node->children[i] != nullptr) {
+                stack.emplace_back(node->children[i], index * 8 + i);
+            }
+        }
+    }
+    return ret;
 }
 
 std::vector<Triangle> const &Scene::primitives() const {
@@ -95,31 +371,42 @@ std::vector<Triangle> const &Scene::primitives() const {
 
 void Scene::to_viewspace(mat4 const &mvp, vec3 const &cam_gaze) {
     this->viewspace_triangles.clear();
-    for (auto const &t : this->realworld_triangles) {
-        // If the triangle has same facing direction as camera's gaze
-        // direction, skip it (face culling).
-        if (glm::dot(cam_gaze, t.facing) >= 0) {
+    size_t            ntriangles = 0;
+    std::vector<vec3> projected;
+    for (Instance const &inst : this->instances) {
+        Geometry const &g = this->geometries[inst.geometry];
+        ntriangles += g.triangles.size();
+        // Mesh-level pre-culling on the instance's bounding box
+        if (this->outside_frustum(inst, mvp)) {
             continue;
         }
-        // Triangle in viewspace
-        Triangle v = t * mvp;
-        for (int i = 0; i < 3; ++i) {
+        mat4 const m    = inst.transform * mvp;
+        vec3 const gaze = this->local_gaze(inst, cam_gaze);
+        // Every shared vertex is transformed once for the instance
+        g.project(m, projected);
+        for (auto const &t : g.triangles) {
+            // If the triangle has same facing direction as camera's gaze
+            // direction, skip it (face culling).
+            if (glm::dot(gaze, t.facing) >= 0) {
+                continue;
+            }
+            // Triangle in viewspace
+            Triangle v = g.vertices.empty() ? t * m : g.transformed(t, projected);
             // Push viewspace triangle only when it has 1 or more vertices
-            // inside the canonical box $[-1, 1]^3$, aka view frustum culling.
+            // inside the canonical box $[-1, 1]^3$, aka view frustum
+            // culling.
             if (v.vert_in_canonical()) {
                 viewspace_triangles.push_back(v);
-                break;
             }
         }
     }
     debugm("real world: %zu triangles, viewspace: %zu triangles\n",
-           this->realworld_triangles.size(),
-           this->viewspace_triangles.size());
+           ntriangles, this->viewspace_triangles.size());
 }
 
 std::tuple<vec3, vec3, vec3> Scene::generate_camera() const {
-    if (nullptr == this->root) {
-        errorm("Octree is somehow not constructed\n");
+    if (this->instances.empty()) {
+        errorm("Scene has no instances to look at\n");
     }
     Camera ret;
     vec3   pos, gaze, up;
@@ -133,16 +420,11 @@ std::tuple<vec3, vec3, vec3> Scene::generate_camera() const {
         // this->root->maxcord[1] * 2,
         // this->root->maxcord[2] * 1,
         // Viewpoint-default
-        this->root->maxcord[0] * 1.5,
-        this->root->maxcord[1] * 2,
-        this->root->maxcord[2] * 1.2,
+        this->bounds.maxp.x * 1.5,
+        this->bounds.maxp.y * 2,
+        this->bounds.maxp.z * 1.2,
     };
-    gaze = glm::normalize(vec3{
-                              this->root->midcord[0],
-                              this->root->midcord[1],
-                              this->root->midcord[2],
-                          } -
-                          pos);
+    gaze = glm::normalize(this->bounds.centroid() - pos);
     up   = glm::normalize(vec3{
         -pos.x,
         std::fabs(gaze.y) < epsilon
@@ -155,82 +437,222 @@ std::tuple<vec3, vec3, vec3> Scene::generate_camera() const {
 
 // private:
 
-void Scene::_build_octree() {
+size_t Scene::_add_geometry(std::vector<Triangle> &&triangles,
+                            BBox const *bbox, FlatOctreeView const *octree) {
+    Geometry g;
+    g.triangles = std::move(triangles);
+    if (octree == nullptr || octree->nnodes == 0) {
+        for (size_t i = 0; i < g.triangles.size(); ++i) {
+            g.triangles[i].indexOfTriangles = i;
+        }
+    }
+    if (bbox != nullptr) {
+        g.bbox = *bbox;
+    } else {
+        for (Triangle const &t : g.triangles) {
+            g.bbox |= t.boundingbox();
+        }
+    }
+    if (this->hierarchy.octree) {
+        if (octree == nullptr) {
+            this->_build_octree(g);
+        } else if (octree->nnodes != 0) {
+            g.root = this->_unflatten(*octree, 0, nullptr);
+        }
+    }
+    // Without the pointer octree the triangles themselves can be kept in
+    // the order of the first other hierarchy, so its traversal reads them
+    // sequentially.
+    bool reorder = !this->hierarchy.octree;
+    if (this->hierarchy.linear_octree) {
+        g.linear.build(g.triangles, g.bbox);
+        if (reorder) {
+            apply_order(g.triangles, g.linear.order);
+            g.linear.order.clear();
+            reorder = false;
+        }
+    }
+    if (this->hierarchy.bvh) {
+        g.bvh.build(g.triangles);
+        if (reorder) {
+            apply_order(g.triangles, g.bvh.order);
+            g.bvh.order.clear();
+        }
+    }
+    this->geometries.push_back(std::move(g));
+    return this->geometries.size() - 1;
+}
+
+void Scene::_build_octree(Geometry &geometry) {
     debugm("Constructing octree in object space ..\n");
-    flt xmin{std::numeric_limits<flt>::max()}, ymin{xmin}, zmin{xmin};
-    flt xmax{-std::numeric_limits<flt>::max()}, ymax{xmax}, zmax{xmax};
-    // Determine size of root node
-    // 寻找所有节点的 xyz的最小值与最大值 
-    for (Triangle const &t : this->realworld_triangles) {
-        xmin = std::min(std::min(xmin, t.a().x), std::min(t.b().x, t.c().x));
-        ymin = std::min(std::min(ymin, t.a().y), std::min(t.b().y, t.c().y));
-        zmin = std::min(std::min(zmin, t.a().z), std::min(t.b().z, t.c().z));
-        xmax = std::max(std::max(xmax, t.a().x), std::max(t.b().x, t.c().x));
-        ymax = std::max(std::max(ymax, t.a().y), std::max(t.b().y, t.c().y));
-        zmax = std::max(std::max(zmax, t.a().z), std::max(t.b().z, t.c().z));
-    }
-    this->root = this->_build(xmin - epsilon, ymin - epsilon, zmin - epsilon,
-                              xmax + epsilon, ymax + epsilon, zmax + epsilon,
-                              this->realworld_triangles, nullptr);
-    msg("Object space octree constructed\n");
-}
-// 0121 tips: 在Node8(Scene.hpp)的（ret->prims）中加入 与 Mesh的对应关系（或者与Mesh中的Indices下标的对应关系？） 
-// 把prims改为一个结构体？
+    if (geometry.triangles.empty()) {
+        geometry.root = nullptr;
+        return;
+    }
+    // Size of root node is the geometry's bounding box
+    BBox const           &b = geometry.bbox;
+    size_t const          n = geometry.triangles.size();
+    std::vector<uint32_t> order(n), scratch(n);
+    std::iota(order.begin(), order.end(), 0);
+    geometry.root = this->_build(
+        b.minp.x - epsilon, b.minp.y - epsilon, b.minp.z - epsilon,
+        b.maxp.x + epsilon, b.maxp.y + epsilon, b.maxp.z + epsilon,
+        geometry.triangles, order, scratch, 0, n, nullptr,
+        this->octree_nodes);
+    // Node ranges refer to positions in `order`, move the triangles there
+    apply_order(geometry.triangles, order);
+}
 Node8 *Scene::_build(flt const &xmin, flt const &ymin, flt const &zmin,
                      flt const &xmax, flt const &ymax, flt const &zmax,
-                     std::vector<Triangle> const &prims, Node8 *fa) {
+                     std::vector<Triangle> const &triangles,
+                     std::vector<uint32_t> &order, std::vector<uint32_t> &scratch,
+                     size_t const &begin, size_t const &end, Node8 *fa,
+                     NodeArena &nodes) {
     // Do not create a node if there is no primitive inside given cubic area.
-    if (prims.size() == 0) {
+    if (begin == end) {
         return nullptr;
     }
-    // Pointer to constructed octree node.
-    Node8 *ret = new Node8{xmin, ymin, zmin, xmax, ymax, zmax};
+    // Pointer to constructed octree node.  [xmin, xmax] etc. is the node's
+    // cell; a loose octree enlarges it around its centre.
+    flt const k   = this->hierarchy.loose;
+    Node8    *ret = nullptr;
+    if (k > 0) {
+        flt const hx = (xmax - xmin) / 2 * k, cx = (xmin + xmax) / 2;
+        flt const hy = (ymax - ymin) / 2 * k, cy = (ymin + ymax) / 2;
+        flt const hz = (zmax - zmin) / 2 * k, cz = (zmin + zmax) / 2;
+        ret = nodes.make(cx - hx, cy - hy, cz - hz, cx + hx, cy + hy,
+                         cz + hz);
+    } else {
+        ret = nodes.make(xmin, ymin, zmin, xmax, ymax, zmax);
+    }
     ret->fa    = fa;
+    ret->begin = begin;
     // Stop subdividing when number of primitives inside cube is less than 24.
-    if (prims.size() < 24) {
+    if (end - begin < 24) {
         ret->isleaf = true;
         // Associate all primitives (less than 24) to current node.
-        ret->prims.assign(prims.begin(), prims.end());
+        ret->end = end;
         return ret;
     }
     // Otherwise, subdivide current cube.
-    std::array<std::vector<Triangle>, 8> subprims;
-    for (auto const &t : prims) {
-        // 检查三角形是否在分割平面上 
-        // 若是，则与当前节点ret发生关联
-        // 否则，寻找此三角形属于的 Node8 子节点
-        if (ret->owns(t)) {
-            ret->prims.push_back(t);
+    // 检查三角形是否在分割平面上：若是，则与当前节点ret发生关联（桶0），
+    // 否则属于 Node8 子节点 index（桶 index + 1）。
+    // 按桶做一次稳定的计数排序，各桶内保持原来的相对顺序。
+    // 大节点把区间切成固定的块并行计数和分发：每块按 (桶, 块) 的顺序
+    // 得到写入位置，结果与串行时完全相同。
+    auto bucket = [&](uint32_t i) -> size_t {
+        Triangle const &t = triangles[i];
+        if (k > 0) {
+            return (ret->loose_index(t, k) + 1) % 9;
+        }
+        return ret->owns(t) ? 0 : ret->index(t) + 1;
+    };
+    bool const   parallel = end - begin >= this->hierarchy.parallel_cutoff;
+    ThreadPool  &pool     = ThreadPool::global();
+    size_t const nchunks =
+        parallel ? std::min((end - begin) / 4096 + 1, pool.size() * 4) : 1;
+    size_t const chunk = (end - begin + nchunks - 1) / nchunks;
+    std::vector<std::array<size_t, 9>> offset(nchunks);
+    auto for_chunks = [&](std::function<void(size_t, size_t)> const &body) {
+        auto run = [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                body(begin + c * chunk, std::min(end, begin + (c + 1) * chunk));
+            }
+        };
+        if (parallel) {
+            pool.parallel_for(0, nchunks, 1, run);
         } else {
-            subprims[ret->index(t)].push_back(t);
-        }
-    }
-
-    ret->children[0] =
-        this->_build(xmin, ymin, zmin, ret->midcord[0], ret->midcord[1],
-                     ret->midcord[2], subprims[0], ret);
-    ret->children[1] =
-        this->_build(ret->midcord[0], ymin, zmin, xmax, ret->midcord[1],
-                     ret->midcord[2], subprims[1], ret);
-    ret->children[2] =
-        this->_build(xmin, ret->midcord[1], zmin, ret->midcord[0], ymax,
-                     ret->midcord[2], subprims[2], ret);
-    ret->children[3] =
-        this->_build(ret->midcord[0], ret->midcord[1], zmin, xmax, ymax,
-                     ret->midcord[2], subprims[3], ret);
-    ret->children[4] =
-        this->_build(xmin, ymin, ret->midcord[2], ret->midcord[0],
-                     ret->midcord[1], zmax, subprims[4], ret);
-    ret->children[5] =
-        this->_build(ret->midcord[0], ymin, ret->midcord[2], xmax,
-                     ret->midcord[1], zmax, subprims[5], ret);
-    ret->children[6] =
-        this->_build(xmin, ret->midcord[1], ret->midcord[2], ret->midcord[0],
-                     ymax, zmax, subprims[6], ret);
-    ret->children[7] =
-        this->_build(ret->midcord[0], ret->midcord[1], ret->midcord[2], xmax,
-                     ymax, zmax, subprims[7], ret);
+            run(0, nchunks);
+        }
+    };
+    for_chunks([&](size_t lo, size_t hi) {
+        std::array<size_t, 9> &count = offset[(lo - begin) / chunk];
+        count.fill(0);
+        for (size_t i = lo; i < hi; ++i) {
+            ++count[bucket(order[i])];
+        }
+    });
+    // bounds[k] is where bucket k starts
+    std::array<size_t, 10> bounds;
+    size_t                 sum = begin;
+    for (size_t k = 0; k < 9; ++k) {
+        bounds[k] = sum;
+        for (std::array<size_t, 9> &count : offset) {
+            size_t const n = count[k];
+            count[k]       = sum;
+            sum += n;
+        }
+    }
+    bounds[9] = end;
+    for_chunks([&](size_t lo, size_t hi) {
+        std::array<size_t, 9> &next = offset[(lo - begin) / chunk];
+        for (size_t i = lo; i < hi; ++i) {
+            scratch[next[bucket(order[i])]++] = order[i];
+        }
+    });
+    for_chunks([&](size_t lo, size_t hi) {
+        std::copy(scratch.begin() + lo, scratch.begin() + hi,
+                  order.begin() + lo);
+    });
+    ret->end = bounds[1];
+
+    // Children cover disjoint parts of `order` and `scratch`, so they can
+    // be built at the same time.
+    std::array<flt, 3> const &mid   = ret->midcord;
+    auto                      build = [&](size_t i, NodeArena &arena) {
+        ret->children[i] = this->_build(
+            i & 1 ? mid[0] : xmin, i & 2 ? mid[1] : ymin,
+            i & 4 ? mid[2] : zmin, i & 1 ? xmax : mid[0],
+            i & 2 ? ymax : mid[1], i & 4 ? zmax : mid[2], triangles, order,
+            scratch, bounds[i + 1], bounds[i + 2], ret, arena);
+    };
+    if (parallel) {
+        // Every child task allocates from an arena of its own, no locking;
+        // they are merged into `nodes` once all children are built.
+        std::array<NodeArena, 8> arenas;
+        pool.parallel_for(0, 8, 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                build(i, arenas[i]);
+            }
+        });
+        for (NodeArena &arena : arenas) {
+            nodes.splice(arena);
+        }
+    } else {
+        for (size_t i = 0; i < 8; ++i) {
+            build(i, nodes);
+        }
+    }
+
+    return ret;
+}
+
+Node8 *Scene::_unflatten(FlatOctreeView const &octree, int32_t n, Node8 *fa) {
+    FlatOctree::Node const &flat = octree.nodes[n];
+    Node8 *ret   = this->octree_nodes.make(
+        flat.mincord[0], flat.mincord[1], flat.mincord[2], flat.maxcord[0],
+        flat.maxcord[1], flat.maxcord[2]);
+    ret->fa      = fa;
+    ret->isleaf  = flat.isleaf != 0;
+    ret->begin   = flat.first;
+    ret->end     = flat.first + flat.count;
+    for (int i = 0; i < 8; ++i) {
+        if (flat.children[i] != -1) {
+            ret->children[i] = this->_unflatten(octree, flat.children[i], ret);
+        }
+    }
+    return ret;
+}
 
+Node8 *Scene::_clone(Node8 const *node, Node8 *fa) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    Node8 *ret = this->octree_nodes.make(*node);
+    ret->fa    = fa;
+    for (Node8 *&child : ret->children) {
+        child = this->_clone(child, ret);
+    }
     return ret;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "Arena.hpp"
+#include "Bvh.hpp"
 #include "Camera.hpp"
+#include "LinearOctree.hpp"
 #include "OBJ_Loader.hpp"
 #include "Triangle.hpp"
 #include "global.hpp"
 
 #include <array>
+#include <cstdint>
 #include <tuple>
 #include <vector>
 
@@ -20,73 +24,6 @@ struct Node8 : Node<8> {
         for (int i = 0; i < 3; ++i) {
             midcord[i] = (mincord[i] + maxcord[i]) / 2;
         }
-
-        /* Generate facets of corresponding cube of current node */
-        // xOz
-        facets[0] = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmax, ymin, zmin},
-            vec3{xmax, ymin, zmax},
-        }};
-        facets[1] = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmax, ymin, zmax},
-            vec3{xmin, ymin, zmax},
-        }};
-        facets[6] = Triangle{{
-            vec3{xmin, ymax, zmin},
-            vec3{xmax, ymax, zmax},
-            vec3{xmax, ymax, zmin},
-        }};
-        facets[7] = Triangle{{
-            vec3{xmin, ymax, zmin},
-            vec3{xmin, ymax, zmax},
-            vec3{xmax, ymax, zmax},
-        }};
-
-        // yOz
-        facets[2] = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmin, ymin, zmax},
-            vec3{xmin, ymax, zmax},
-        }};
-        facets[3] = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmin, ymax, zmax},
-            vec3{xmin, ymax, zmin},
-        }};
-        facets[8] = Triangle{{
-            vec3{xmax, ymin, zmin},
-            vec3{xmax, ymax, zmax},
-            vec3{xmax, ymin, zmax},
-        }};
-        facets[9] = Triangle{{
-            vec3{xmax, ymin, zmin},
-            vec3{xmax, ymax, zmin},
-            vec3{xmax, ymax, zmax},
-        }};
-
-        // xOy
-        facets[4]  = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmax, ymax, zmin},
-            vec3{xmax, ymin, zmin},
-        }};
-        facets[5]  = Triangle{{
-            vec3{xmin, ymin, zmin},
-            vec3{xmin, ymax, zmin},
-            vec3{xmax, ymax, zmin},
-        }};
-        facets[10] = Triangle{{
-            vec3{xmin, ymin, zmax},
-            vec3{xmax, ymin, zmax},
-            vec3{xmax, ymax, zmax},
-        }};
-        facets[11] = Triangle{{
-            vec3{xmin, ymin, zmax},
-            vec3{xmax, ymax, zmax},
-            vec3{xmin, ymax, zmax},
-        }};
     }
 
     // Check if triangle `t` lies on any of the dividing planes of the cube
@@ -127,57 +64,288 @@ struct Node8 : Node<8> {
         return masks[0] | masks[1] | masks[2];
     }
 
+    // Loose octree counterpart of `owns` and `index`, for a node whose
+    // cube is its cell enlarged `k` times around `midcord`.  Returns the
+    // index of the child whose cell holds the centroid of `t`, or 8 when
+    // `t` does not fit inside that child's (equally enlarged) cube and
+    // stays with current node.
+    size_t loose_index(Triangle const &t, flt const &k) const {
+        BBox const &b = t.boundingbox();
+        vec3 const  c = (t.a() + t.b() + t.c()) / 3.0;
+        size_t      ret{0};
+        for (int i = 0; i < 3; ++i) {
+            // Half the size of a child's cube, and the centre of its cell
+            flt const  half  = (this->maxcord[i] - this->mincord[i]) / 4;
+            bool const upper = c[i] > this->midcord[i];
+            flt const  centre =
+                this->midcord[i] + (upper ? half : -half) / k;
+            if (b.minp[i] < centre - half || b.maxp[i] > centre + half) {
+                return 8;
+            }
+            ret |= static_cast<size_t>(upper) << i;
+        }
+        return ret;
+    }
+
+    // Index of the child whose octant holds point `p`, numbered like
+    // `index`
+    size_t octant(vec3 const &p) const {
+        return (p.x > this->midcord[0]) | (p.y > this->midcord[1]) << 1 |
+               (p.z > this->midcord[2]) << 2;
+    }
+
+    // Cube of current node
+    BBox cube() const {
+        return BBox{vec3{this->mincord[0], this->mincord[1], this->mincord[2]},
+                    vec3{this->maxcord[0], this->maxcord[1], this->maxcord[2]}};
+    }
+
     // Father
     Node8 *fa;
     // Children
     std::array<Node8 *, 8> children;
 
-    // Min values of current cube (0:x, 1:y, 2:z)
+    // Min values of current cube (0:x, 1:y, 2:z).  For a loose octree the
+    // cube is the node's cell enlarged around `midcord`, so that it bounds
+    // every triangle of the subtree.
     std::array<flt, 3> mincord;
     // Max values of current cube (0:x, 1:y, 2:z)
     std::array<flt, 3> maxcord;
     // Splitting values (0:x, 1:y, 2:z)
     // 用于 拆分八叉树的 值
     std::array<flt, 3> midcord;
-    // 6 faces, 2 triangles per face.
-    // 立方体6个面，每个面两个三角形 （xOz面4个，xOy面4个，yOz面4个）
-    std::array<Triangle, 12> facets;
-    // Associated primitives
-    std::vector<Triangle> prims;
+    // Associated primitives are `Geometry::triangles[begin, end)`.  The
+    // triangles of a subtree are contiguous: this node's own ones first,
+    // followed by those of children 0..7 in order.  Own triangles are the
+    // ones crossing a dividing plane (see `owns`), or for a loose octree
+    // the ones too large for their child's cube (see `loose_index`).
+    size_t begin;
+    size_t end;
+};
+
+// Pointer-free form of a geometry's octree, e.g. for caching it on disk.
+// Nodes are stored in pre-order with the root at index 0, so every child
+// comes after its parent.  `prims` is the octree's triangle order, so
+// node ranges index into it directly.
+struct FlatOctree {
+    struct Node {
+        flt mincord[3];
+        flt maxcord[3];
+        // Indices into `nodes`, -1 for an empty child
+        int32_t children[8];
+        // This node's triangles are `prims[first, first + count)`
+        uint32_t first;
+        uint32_t count;
+        uint32_t isleaf;
+        uint32_t padding;
+    };
+    std::vector<Node> nodes;
+    // `indexOfTriangles` of every triangle of the geometry, in the order
+    // of Geometry::triangles after the octree was built
+    std::vector<uint32_t> prims;
+
+    // Whether this is a well-formed tree over a geometry of `ntriangles`
+    // triangles (children after their parents, at most one parent per node,
+    // ranges in bounds, `prims` a permutation).
+    bool valid(size_t ntriangles) const;
+};
+
+// Read-only view of the arrays of a FlatOctree, which may live outside
+// of one, e.g. in a mapped cache file.  The arrays must outlive the view.
+struct FlatOctreeView {
+    FlatOctreeView() = default;
+    FlatOctreeView(FlatOctree const &octree)
+        : nodes{octree.nodes.data()}, nnodes{octree.nodes.size()},
+          prims{octree.prims.data()}, nprims{octree.prims.size()} {}
+
+    FlatOctree::Node const *nodes  = nullptr;
+    size_t                  nnodes = 0;
+    uint32_t const         *prims  = nullptr;
+    size_t                  nprims = 0;
+
+    // Same as FlatOctree::valid
+    bool valid(size_t ntriangles) const;
+};
+
+// Spatial hierarchies the Scene builds over every geometry.
+struct HierarchyOptions {
+    // Pointer octree (Geometry::root), for rendering_method::octree
+    bool octree = true;
+    // Morton-code linear octree (Geometry::linear), for
+    // rendering_method::linear_octree
+    bool linear_octree = false;
+    // Binned SAH bounding volume hierarchy (Geometry::bvh), for
+    // rendering_method::bvh
+    bool bvh = false;
+    // Pointer octree nodes with at least this many triangles partition
+    // them in parallel and build their children as concurrent tasks;
+    // smaller subtrees are built serially.  The tree is the same either
+    // way.
+    size_t parallel_cutoff = 1 << 14;
+    // Zero builds the classic pointer octree.  A factor k >= 1 builds a
+    // loose octree instead: every node's cube is its cell enlarged k times,
+    // and a triangle goes to the child holding its centroid as long as it
+    // fits inside that child's cube.
+    flt loose = 0;
+};
+
+// A block of triangles shared by every instance that references it.
+// Coordinates are in the geometry's own (local) space, and its octree is
+// built once over them.
+struct Geometry {
+    Geometry() : first{0}, root{nullptr} {}
+
+    // Transforms every vertex once with `m` (homogeneous division
+    // included) into `out`, for use with `transformed`.
+    void project(mat4 const &m, std::vector<vec3> &out) const;
+    // Same as `t * m` for a triangle of this geometry, assembled from the
+    // output of `project` instead of transforming its 3 vertices again.
+    Triangle transformed(Triangle const &t,
+                         std::vector<vec3> const &projected) const;
+
+    // Stored once, in octree order (see Node8::begin); without the pointer
+    // octree, in the order of the linear octree or else the BVH.  A
+    // triangle's position before that is its `indexOfTriangles`.
+    std::vector<Triangle> triangles;
+    // Vertices shared by the triangles, in local space: vertex `index_a`
+    // of a triangle is `vertices[index_a - first]`.  Empty when the
+    // geometry was built from unindexed triangles.
+    std::vector<vec3> vertices;
+    size_t            first;
+    // Bounding box of all triangles, in local space
+    BBox bbox;
+    // Root node of the local space octree, its nodes belong to the Scene
+    Node8 *root;
+    // Local space linear octree, empty unless HierarchyOptions::linear_octree
+    LinearOctree linear;
+    // Local space BVH, empty unless HierarchyOptions::bvh
+    Bvh bvh;
+};
+
+// One placement of a geometry in the world.
+struct Instance {
+    // Index into Scene::geometries
+    size_t geometry;
+    // Local-to-world transformation, applied the same way as mvp
+    // (`homo * transform`), so the instance's own mvp is `transform * mvp`.
+    mat4 transform;
+    // Position of this instance's first triangle in Scene::deleted
+    size_t first;
+    // World space bounding box, from the 8 transformed corners of the
+    // geometry's bounding box
+    BBox bounds;
+    // 实例名（glTF node name）
+    std::string name;
 };
 
 class Scene {
   public:
-    // Triangles with real-world coordinates
-    std::vector<Triangle> realworld_triangles;
+    // Unique geometry, stored once no matter how often it is instanced
+    std::vector<Geometry> geometries;
+    // Instances in insertion order
+    std::vector<Instance> instances;
+    // Culling result of every instanced triangle: triangle `t` of instance
+    // `i` is at `deleted[i.first + t.indexOfTriangles]`, non-zero when
+    // culled.
+    std::vector<unsigned char> deleted;
+    // World space bounding box of all instances
+    BBox bounds;
+    // Hierarchies built by `_add_geometry`
+    HierarchyOptions hierarchy;
 
     // Triangles with view-space coordinates
     std::vector<Triangle> viewspace_triangles;
 
+  private:
+    using NodeArena = Arena<Node8, 256>;
+    // Storage of every geometry's octree nodes, released with the scene
+    NodeArena octree_nodes;
+
   private:
     void _init();
 
+    // Adds a geometry built from local space triangles and constructs its
+    // octree.  Each triangle's `indexOfTriangles` is set to its position
+    // inside the geometry.
+    // When `bbox` is given it must bound every triangle, and is taken as the
+    // geometry's bounding box instead of merging the triangles' boxes again.
+    // When a non-empty `octree` is given the geometry's octree is restored
+    // from it instead of being built; `triangles` must then already be in
+    // the octree's order (`octree->prims`), with `indexOfTriangles` set.
+    size_t _add_geometry(std::vector<Triangle> &&triangles,
+                         BBox const *bbox = nullptr,
+                         FlatOctreeView const *octree = nullptr);
+
     // This function is the frontend of octree construction.
-    // It is called upon succesfully load of mesh triangles, the octree is
-    // built upon all real world triangles.
-    void _build_octree();
+    // It is called once per geometry, the octree is built upon all of the
+    // geometry's triangles, which are then reordered into octree order.
+    void _build_octree(Geometry &geometry);
 
-    // Actual octree recursive construction function
+    // Actual octree recursive construction function.  Builds the node for
+    // the triangles `triangles[order[begin, end)]`, stably partitioning
+    // that part of `order` by node (`scratch` is a buffer of the same
+    // size), so no triangle is copied during the build.  Nodes above
+    // `hierarchy.parallel_cutoff` run on the global thread pool.  The
+    // subtree's nodes are allocated from `nodes`.
     Node8 *_build(flt const &xmin, flt const &ymin, flt const &zmin,
                   flt const &xmax, flt const &ymax, flt const &zmax,
-                  std::vector<Triangle> const &prims, Node8 *fa);
+                  std::vector<Triangle> const &triangles,
+                  std::vector<uint32_t> &order, std::vector<uint32_t> &scratch,
+                  size_t const &begin, size_t const &end, Node8 *fa,
+                  NodeArena &nodes);
 
-  public:
-    // Root node of object space octree
-    Node8 *root;
+    // Rebuilds node `n` of a flattened octree and its subtree
+    Node8 *_unflatten(FlatOctreeView const &octree, int32_t n, Node8 *fa);
+    // Copies the subtree rooted at `node` into this scene's nodes
+    Node8 *_clone(Node8 const *node, Node8 *fa);
 
   public:
     Scene();
     // Construct a scene with loaded mesh
     Scene(objl::Mesh const &mesh);
     Scene(objl::Mesh const &mesh,std::vector<int> meshLength,std::vector<std::string> meshName);   // 20220211 add
+    // Construct the geometries of a scene straight from decoded vertex data:
+    // `positions` holds xyz triples, every 3 entries of `indices` form a
+    // triangle, and geometry `g` consists of the `ranges[g].second` indices
+    // starting at `ranges[g].first`.  Instances are added afterwards with
+    // `add_instance`.  Every geometry's bounding box is merged from its
+    // vertices while its triangles are assembled.  `octrees`, when not
+    // empty, holds the flattened octree of every geometry (see
+    // `flatten_octree`), which is then restored instead of built, and
+    // whose triangle order the triangles are assembled in directly.
+    // `hierarchy` selects the spatial hierarchies to build.
+    Scene(std::vector<float> const &positions, std::vector<int> const &indices,
+          std::vector<pss> const &ranges,
+          std::vector<FlatOctreeView> const &octrees   = {},
+          HierarchyOptions const            &hierarchy = {});
     // Construct a scene with a list of triangles
     Scene(std::vector<Triangle> const &tgs);
+    // Copies get octrees of their own
+    Scene(Scene const &rhs);
+    Scene &operator=(Scene const &rhs);
+    // Moves take the octrees along, nodes keep their addresses
+    Scene(Scene &&rhs) noexcept = default;
+    Scene &operator=(Scene &&rhs) noexcept = default;
+
+    // Place geometry `geometry` in the world with the given local-to-world
+    // transformation, returns index of the new instance.
+    size_t add_instance(size_t const &geometry, mat4 const &transform,
+                        std::string const &name = "");
+
+    // Camera gaze direction expressed in the local space of `instance`, for
+    // face culling against the instance's local space facing directions:
+    // a triangle faces away iff dot(local_gaze, facing) >= 0.
+    vec3 local_gaze(Instance const &instance, vec3 const &gaze) const;
+
+    // Whether `instance` lies entirely outside the view frustum, tested on
+    // its world space bounding box only.  Conservative: returns false when
+    // unsure (e.g. the box straddles the camera plane).
+    bool outside_frustum(Instance const &instance, mat4 const &mvp) const;
+    // Same test for any box `b`, transformed by `mvp`
+    static bool outside_frustum(BBox const &b, mat4 const &mvp);
+
+    // Octree of geometry `geometry` in pointer-free form
+    FlatOctree flatten_octree(size_t const &geometry) const;
 
     std::vector<Triangle> const &primitives() const;
 
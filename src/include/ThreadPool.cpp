@@ -0,0 +1,115 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t const &nthreads) : stopping{false} {
+    size_t n = nthreads ? nthreads : std::thread::hardware_concurrency();
+    for (size_t i = 1; i < n; ++i) {
+        this->workers.emplace_back([this] { this->_worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->stopping = true;
+    }
+    this->cv.notify_all();
+    for (std::thread &t : this->workers) {
+        t.join();
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::size() const { return this->workers.size() + 1; }
+
+void ThreadPool::parallel_for(
+    size_t const &begin, size_t const &end, size_t const &grain,
+    std::function<void(size_t, size_t)> const &body) {
+    if (begin >= end) {
+        return;
+    }
+    size_t step = std::max<size_t>(grain, 1);
+    size_t nchunks = (end - begin + step - 1) / step;
+    if (nchunks == 1 || this->workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    // The first exception thrown by `body` is rethrown to the caller once
+    // all chunks have finished.
+    std::exception_ptr error;
+    std::mutex         error_mtx;
+    auto               run = [&](size_t lo, size_t hi) {
+        try {
+            body(lo, hi);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::atomic<size_t> remaining{nchunks - 1};
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        for (size_t lo = begin + step; lo < end; lo += step) {
+            size_t hi = std::min(lo + step, end);
+            this->tasks.emplace_back([&run, &remaining, lo, hi] {
+                run(lo, hi);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+    }
+    this->cv.notify_all();
+
+    // The caller takes the first chunk, then helps drain the queue until
+    // every chunk of this loop has finished.
+    run(begin, std::min(begin + step, end));
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!this->_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::_worker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->cv.wait(lock, [this] {
+                return this->stopping || !this->tasks.empty();
+            });
+            if (this->tasks.empty()) {
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+        task();
+    }
+}
+
+bool ThreadPool::_run_one() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        if (this->tasks.empty()) {
+            return false;
+        }
+        task = std::move(this->tasks.front());
+        this->tasks.pop_front();
+    }
+    task();
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads sharing one FIFO task queue.  A thread
+// that waits on a parallel loop keeps running queued tasks instead of
+// blocking, so parallel loops may be nested.
+class ThreadPool {
+  public:
+    // Spawns `nthreads - 1` workers; the calling thread is the last one.
+    // Zero means one thread per hardware core.
+    ThreadPool(size_t const &nthreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    // Process-wide pool, created on first use.
+    static ThreadPool &global();
+
+    // Number of threads taking part in a parallel loop (workers + caller).
+    size_t size() const;
+
+    // Calls `body(lo, hi)` on disjoint sub-ranges covering [begin, end),
+    // each at most `grain` long, and returns when all of them are done.
+    // An exception thrown by `body` is rethrown here.
+    void parallel_for(size_t const &begin, size_t const &end,
+                      size_t const &grain,
+                      std::function<void(size_t, size_t)> const &body);
+
+  private:
+    void _worker();
+    // Runs one queued task if there is one.
+    bool _run_one();
+
+  private:
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex                        mtx;
+    std::condition_variable           cv;
+    bool                              stopping;
+};
@@ -1,6 +1,25 @@
 #include "Zbuf.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// Children of an octree node in front-to-back order for a camera in octant
+// `o` of the node (see Node8::octant): the camera's own octant first, then
+// those across one, two and all three dividing planes.  A child can only be
+// hidden by children listed before it.
+static std::array<std::array<uint8_t, 8>, 8> constexpr front_to_back = [] {
+    std::array<std::array<uint8_t, 8>, 8> ret{};
+    uint8_t constexpr by_planes_crossed[8] = {0, 1, 2, 4, 3, 5, 6, 7};
+    for (uint8_t o = 0; o < 8; ++o) {
+        for (uint8_t k = 0; k < 8; ++k) {
+            ret[o][k] = o ^ by_planes_crossed[k];
+        }
+    }
+    return ret;
+}();
+
 Zbuf::Zbuf() { this->_init(); }
 Zbuf::Zbuf(Scene const &s) : scene{s} { this->_init(); }
 Zbuf::Zbuf(Scene const &s, size_t const &width, size_t const &height)
@@ -23,6 +42,10 @@ void Zbuf::set_shader(
     this->frag_shader = shader_func;
 }
 
+void Zbuf::set_prim_sorting(bool const &enabled) {
+    this->sort_prims = enabled;
+}
+
 void Zbuf::init_cam(vec3 const &ey, flt const &fovy, flt const &aspect_ratio,
                     flt const &znear, flt const &zfar, vec3 const &gaze,
                     vec3 const &up) {
@@ -139,7 +162,9 @@ void Zbuf::render(rendering_method const &type) {
     if (!this->viewport_initialized) {
         errorm("Viewport size is not initialized\n");
     }
-    if (type == rendering_method::octree) {
+    if (type == rendering_method::octree ||
+        type == rendering_method::linear_octree ||
+        type == rendering_method::bvh) {
         // 改:add FILE* file
         // modify: index data saved in out_index.obj
     	FILE* file = fopen("./out_index.obj", "w");
@@ -154,7 +179,50 @@ void Zbuf::render(rendering_method const &type) {
 			system("PAUSE");
 			exit(0);
 		}
-        this->_render_with_octree(this->scene.root,file,file2);
+        // Every instance is culled through the octree of its geometry, which
+        // is shared by all instances of it.
+        HierarchyOptions const &built = this->scene.hierarchy;
+        if (!(type == rendering_method::linear_octree ? built.linear_octree
+              : type == rendering_method::bvh         ? built.bvh
+                                                      : built.octree)) {
+            errorm("The scene was built without the hierarchy of this "
+                   "rendering method\n");
+        }
+        // w of a point straight ahead, whose sign tells the frustum planes
+        // which side of the camera is in front
+        flt const ahead =
+            (vec4{0, 0, (this->cam.znear() + this->cam.zfar()) / 2, 1} *
+             this->projection)
+                .w;
+        for (Instance const &inst : this->scene.instances) {
+            Geometry const &g = this->scene.geometries[inst.geometry];
+            // Mesh-level pre-culling on the instance's bounding box, before
+            // touching the octree
+            if (g.triangles.empty() ||
+                this->scene.outside_frustum(inst, this->mvp)) {
+                continue;
+            }
+            mat4 const m    = inst.transform * this->mvp;
+            vec3 const gaze = this->scene.local_gaze(inst, this->cam.gaze());
+            g.project(m, this->projected);
+            this->frustum = Frustum{m, ahead};
+            // Positions are `local * transform`, so the camera goes back
+            // through the inverse, and depth along the gaze is
+            // dot(local * A, gaze) = dot(local, gaze * A^T)
+            vec4 const eye =
+                vec4{this->cam.pos(), 1} * glm::inverse(inst.transform);
+            this->eye        = vec3{eye} / eye.w;
+            this->depth_axis =
+                this->cam.gaze() * glm::transpose(mat3(inst.transform));
+            if (type == rendering_method::linear_octree) {
+                this->_render_with_linear_octree(inst, m, gaze, file, file2);
+            } else if (type == rendering_method::bvh) {
+                this->_render_with_bvh(inst, m, gaze, file, file2);
+            } else {
+                this->_render_with_octree(g.root, 0, inst, m, gaze, file,
+                                          file2);
+            }
+        }
     } else {
         this->scene.to_viewspace(this->mvp, this->cam.gaze());
         for (Triangle const &v : this->scene.primitives()) {
@@ -175,6 +243,7 @@ void Zbuf::_init() {
     this->mvp_initialized      = false;
     this->viewport_initialized = false;
     this->frag_shader          = nullptr;
+    this->sort_prims           = false;
 }
 
 bool Zbuf::inside(flt x, flt y, Triangle const &t) const {
@@ -277,78 +346,134 @@ bool Zbuf::_draw_triangle_with_zpyramid(Triangle const &v) {
     return ret;
 }
 
-// node是scene->root
-// 改：去掉 const
-void Zbuf::_render_with_octree(Node8 *node,FILE* file,FILE* file2) {
-    std::vector<Triangle> facets;
-    // Convert to view space coordinates
-    for (int i = 0; i < 12; ++i) {
-        // Face culling
-        if (glm::dot(this->cam.gaze(), node->facets[i].facing) >= 0) {
-            continue;
-        }
-        facets.push_back(node->facets[i] * mvp);
-    }
-    printf("%d ",facets.size());
-    // Check if this cube intersects with the view frustum (view frustum
-    // culling)
-    // Note: this is not deterministic but quite enough
-    bool invisible{true};
-    for (auto const &v : facets) {
-        for (int i = 0; i < 3; ++i) {
-            if (v.vert_in_canonical()) {
-                invisible = false;
-                break;
-            }
-        }
-    }
-    // When the cube does not intersects with the view frustum, it can be
-    // safely ignored.
-    if (invisible) {
-        printf("continue ");
+// node是instance的geometry的octree节点
+void Zbuf::_render_with_octree(Node8 const *node, Frustum::Mask mask,
+                               Instance const &inst, mat4 const &mvp,
+                               vec3 const &gaze, FILE *file, FILE *file2) {
+    Geometry const &g = this->scene.geometries[inst.geometry];
+    // View frustum culling: when the cube does not intersect with the view
+    // frustum, it can be safely ignored.  Once it lies inside all planes,
+    // none of its descendants is tested again.
+    if (mask != Frustum::inside &&
+        !this->frustum.intersects(node->cube(), mask)) {
         return;
     }
     // When the cube does intersect with the view frustum, render the
     // triangles associated with it, and dive into its child nodes.
-    // 改：去掉const &
-    for (Triangle t : node->prims) {
-        // Face culling
-        //fprintf(file, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
-        if (glm::dot(this->cam.gaze(), t.facing) >= 0) {
-            t.deleted = true ;
-            this->scene.realworld_triangles[t.indexOfTriangles].deleted = true ;
-            fprintf(file2, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
-            continue;
+    if (this->sort_prims && node->end - node->begin > 1) {
+        // 按视线方向的深度由近到远
+        std::vector<std::pair<flt, size_t>> &order = this->prim_order;
+        order.clear();
+        for (size_t i = node->begin; i < node->end; ++i) {
+            Triangle const &t = g.triangles[i];
+            order.emplace_back(
+                glm::dot(t.a() + t.b() + t.c(), this->depth_axis), i);
         }
-        // Convert to view space
-        Triangle v = t * this->mvp;
-        // View frustum culling
-        for (int i = 0; i < 3; ++i) {
-            if (v.vert_in_canonical()) {
-                // this->_draw_triangle_with_zpyramid(v);
-                // 改：加判断
-                if(this->_draw_triangle_with_zpyramid(v)){
-                	//printf("%d %d %d \n",t.index_a,t.index_b,t.index_c);
-                	
-                    fprintf(file, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
-                }
-                else{
-                     printf("in ");
-                     t.deleted = true ;
-                     this->scene.realworld_triangles[t.indexOfTriangles].deleted = true ;
-                     fprintf(file2, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
-                }
-                
-                break;
-            }
+        std::sort(order.begin(), order.end());
+        for (auto const &[depth, i] : order) {
+            this->_cull_triangle(g.triangles[i], inst, mvp, gaze, file,
+                                 file2);
+        }
+    } else {
+        for (size_t i = node->begin; i < node->end; ++i) {
+            this->_cull_triangle(g.triangles[i], inst, mvp, gaze, file,
+                                 file2);
         }
     }
-    // Recurse into child nodes. // 8个children 
-    for (Node8 *child : node->children) {
+    // Recurse into child nodes front to back. // 8个children
+    for (uint8_t i : front_to_back[node->octant(this->eye)]) {
+        Node8 const *child = node->children[i];
         if (child == nullptr) {
             continue;
         }
-        this->_render_with_octree(child,file,file2);
+        this->_render_with_octree(child, mask, inst, mvp, gaze, file, file2);
+    }
+}
+
+void Zbuf::_render_with_linear_octree(Instance const &inst, mat4 const &mvp,
+                                      vec3 const &gaze, FILE *file,
+                                      FILE *file2) {
+    Geometry const     &g    = this->scene.geometries[inst.geometry];
+    LinearOctree const &tree = g.linear;
+    // Depth-first with an explicit stack; children are pushed in reverse so
+    // that they are visited in octant order, like the pointer octree.  Each
+    // entry carries the frustum planes its parent lies inside of.
+    std::vector<std::pair<uint32_t, Frustum::Mask>> stack{{0, 0}};
+    while (!stack.empty()) {
+        auto [index, mask]             = stack.back();
+        LinearOctree::Node const &node = tree.nodes[index];
+        stack.pop_back();
+        if (mask != Frustum::inside &&
+            !this->frustum.intersects(node.bounds, mask)) {
+            continue;
+        }
+        for (uint32_t c = node.nchildren; c-- > 0;) {
+            stack.emplace_back(node.first_child + c, mask);
+        }
+        if (node.nchildren != 0) {
+            continue;
+        }
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            this->_cull_triangle(g.triangles[tree.triangle(i)], inst, mvp,
+                                 gaze, file, file2);
+        }
+    }
+}
+
+void Zbuf::_render_with_bvh(Instance const &inst, mat4 const &mvp,
+                            vec3 const &gaze, FILE *file, FILE *file2) {
+    Geometry const &g    = this->scene.geometries[inst.geometry];
+    Bvh const      &tree = g.bvh;
+    std::vector<std::pair<uint32_t, Frustum::Mask>> stack{{0, 0}};
+    while (!stack.empty()) {
+        auto [index, mask]    = stack.back();
+        Bvh::Node const &node = tree.nodes[index];
+        stack.pop_back();
+        if (mask != Frustum::inside &&
+            !this->frustum.intersects(node.bounds, mask)) {
+            continue;
+        }
+        if (!node.isleaf()) {
+            stack.emplace_back(node.second, mask);
+            stack.emplace_back(index + 1, mask);
+            continue;
+        }
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            this->_cull_triangle(g.triangles[tree.triangle(i)], inst, mvp,
+                                 gaze, file, file2);
+        }
+    }
+}
+
+void Zbuf::_cull_triangle(Triangle const &t, Instance const &inst,
+                          mat4 const &mvp, vec3 const &gaze, FILE *file,
+                          FILE *file2) {
+    Geometry const &g = this->scene.geometries[inst.geometry];
+    unsigned char  &deleted = this->scene.deleted[inst.first + t.indexOfTriangles];
+    // Face culling
+    //fprintf(file, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
+    if (glm::dot(gaze, t.facing) >= 0) {
+        deleted = true ;
+        fprintf(file2, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
+        return;
+    }
+    // Convert to view space
+    Triangle v = g.vertices.empty() ? t * mvp
+                                    : g.transformed(t, this->projected);
+    // View frustum culling
+    if (v.vert_in_canonical()) {
+        // this->_draw_triangle_with_zpyramid(v);
+        // 改：加判断
+        if(this->_draw_triangle_with_zpyramid(v)){
+            //printf("%d %d %d \n",t.index_a,t.index_b,t.index_c);
+
+            fprintf(file, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
+        }
+        else{
+             printf("in ");
+             deleted = true ;
+             fprintf(file2, "f %d// %d// %d//\n",t.index_a+1,t.index_b+1,t.index_c+1);
+        }
     }
 }
 
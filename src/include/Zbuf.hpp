@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "Camera.hpp"
+#include "Frustum.hpp"
 #include "Pyramid.hpp"
 #include "Scene.hpp"
 #include "global.hpp"
@@ -13,6 +14,8 @@ enum rendering_method {
     naive,    // render with AABB of each triangle
     zpyramid, // render with z-pyramid only
     octree,   // render with z-pyramid + octree
+    linear_octree, // render with z-pyramid + linear (Morton) octree
+    bvh,      // render with z-pyramid + SAH bounding volume hierarchy
 };
 
 class Zbuf {
@@ -45,6 +48,20 @@ class Zbuf {
 
     std::function<void(Triangle const &)> method;
 
+    // Vertices of the instance being rendered with the octree, transformed
+    // once by its mvp (see Geometry::project)
+    std::vector<vec3> projected;
+    // View frustum in the local space of the instance being rendered
+    Frustum frustum;
+    // Camera position and gaze direction in the local space of the instance
+    // being rendered, for front-to-back traversal
+    vec3 eye;
+    vec3 depth_axis;
+    // Whether an octree node's own triangles are culled nearest first
+    bool sort_prims;
+    // Scratch buffer for sorting a node's triangles: (depth, position)
+    std::vector<std::pair<flt, size_t>> prim_order;
+
   private:
     // Set default values
     void _init();
@@ -77,10 +94,36 @@ class Zbuf {
     // left-bottom corner of the image.
     flt &      z(size_t const &x, size_t const &y);
     flt const &z(size_t const &x, size_t const &y) const;
-    // Recurse octree from give node address, convert coordinates and render
-    // on the fly.
-    // void _render_with_octree(Node8 const *node,FILE* file,FILE* file2);
-    void _render_with_octree(Node8 *node,FILE* file,FILE* file2);   // 改 去掉const
+    // Recurse octree of an instance's geometry from give node address,
+    // convert coordinates and render on the fly.  Nodes are tested against
+    // `frustum`, skipping the planes in `mask` that an ancestor was found
+    // to lie inside of.  Children are visited front to back as seen from
+    // `eye`, so near occluders fill the z-pyramid before the geometry they
+    // hide is tested.
+    // @param inst: Instance being rendered, culled triangles are flagged in
+    //              `scene.deleted` at `inst.first + t.indexOfTriangles`
+    // @param  mvp: The instance's own mvp (`inst.transform * mvp`)
+    // @param gaze: Camera gaze in the instance's local space, see
+    //              Scene::local_gaze
+    void _render_with_octree(Node8 const *node, Frustum::Mask mask,
+                             Instance const &inst, mat4 const &mvp,
+                             vec3 const &gaze, FILE *file, FILE *file2);
+    // Same as `_render_with_octree`, over the instance geometry's linear
+    // octree.  Nodes are tested with their triangles' bounding box.
+    void _render_with_linear_octree(Instance const &inst, mat4 const &mvp,
+                                    vec3 const &gaze, FILE *file,
+                                    FILE *file2);
+    // Same as `_render_with_linear_octree`, over the instance geometry's
+    // BVH.
+    void _render_with_bvh(Instance const &inst, mat4 const &mvp,
+                          vec3 const &gaze, FILE *file, FILE *file2);
+    // Culls local space triangle `t` of the instance being rendered: face
+    // culling, view frustum culling and the z-pyramid test.  Culled
+    // triangles are flagged in `scene.deleted`, and the indices of every
+    // triangle go to `file` (kept) or `file2` (culled).
+    void _cull_triangle(Triangle const &t, Instance const &inst,
+                        mat4 const &mvp, vec3 const &gaze, FILE *file,
+                        FILE *file2);
 
   public:
     Image const &image() const;
@@ -93,6 +136,12 @@ class Zbuf {
     Zbuf(Scene const &s);
     // Initialize a zbuffer object with given scene and viewport size
     Zbuf(Scene const &s, size_t const &width, size_t const &height);
+    // Copies own a scene and depth buffer of their own, moves take them
+    // along (see Scene and Pyramid)
+    Zbuf(Zbuf const &) = default;
+    Zbuf &operator=(Zbuf const &) = default;
+    Zbuf(Zbuf &&) = default;
+    Zbuf &operator=(Zbuf &&) = default;
 
     // Reset member variables to an initial state for next rendering. This
     // function:
@@ -104,6 +153,9 @@ class Zbuf {
     void set_shader(
         std::function<Color(Triangle const &t, Triangle const &v,
                             std::tuple<flt, flt, flt> const &barycentric)>);
+    // Cull each octree node's own triangles in order of view depth,
+    // nearest first (off by default)
+    void set_prim_sorting(bool const &enabled);
     // Set camera's {ex,in}trinsincs
     void init_cam(vec3 const &ey, flt const &fovy, flt const &aspect_ratio,
                   flt const &znear, flt const &zfar,
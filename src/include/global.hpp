@@ -131,9 +131,10 @@ struct BBox {
         return this->minp + (this->maxp - this->minp) * 0.5;
     }
     vec3 constexpr extent() const { return this->maxp - this->minp; }
+    // Surface area
     flt constexpr area() const {
         vec3 e = this->extent();
-        return 2 * (e.x * e.x + e.y * e.y + e.z * e.z);
+        return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
     }
     std::size_t constexpr max_dir() const {
         vec3 e = this->extent();
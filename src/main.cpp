@@ -1,8 +1,8 @@
 #include <iostream>
 #include "gltfLoader/gltf.h"
 #include "export_json.h"
+#include "SceneCache.hpp"
 
-#include "OBJ_Loader.hpp"
 #include "Scene.hpp"
 #include "Timer.hpp"
 #include "Triangle.hpp"
@@ -11,103 +11,122 @@
 #include "shaders.hpp"
 
 #include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <cstdio>
 #include <cstring>
 
 using namespace std;
 
-void outputCulledModel(gltf::Asset &asset, Zbuf zbuf, objl::Loader loader) {
-    
-    ofstream fout;
-    fout.open("./sceneTestCulled.bin", ios::out|ios::binary);        // 模型被剔除部分的bin文件
-
-    int byteLengthIndexCulled = 0, byteLengthVertexCulled = 0;        // 被剔除部分的bytelength
-    for(int i=0; i<zbuf.scene.realworld_triangles.size(); i++){
-        if(zbuf.scene.realworld_triangles[i].deleted != 0){
-            // float a = zbuf.scene.realworld_triangles[i].a()[0] ;
-            float a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            byteLengthVertexCulled += sizeof(float) * 9 ;
+// 按instance依次把 (是否被剔除 == culled) 的三角形的世界坐标写入bin文件
+// 每个instance只把自己的geometry变换一次，三角形按iV中的原顺序从中取坐标
+// （scene中的三角形已按八叉树重排，不能按那个顺序写）
+static int writeTrianglePositions(ostream &fout, gltf::Asset const &asset, Scene const &scene, bool culled) {
+    int byteLength = 0;
+    vector<float> world;
+    for (size_t i = 0; i < scene.instances.size(); ++i) {
+        Instance const &inst = scene.instances[i];
+        gltf::Geometry const &geometry = asset.geometries[asset.instances[i].geometry];
+        float const *local = asset.vV.data() + 3 * geometry.vertexOffset;
+        world.assign(local, local + 3 * geometry.vertexCount);
+        gltf::transformPositions(asset.nodes[asset.instances[i].node].worldMatrix, world.data(), geometry.vertexCount);
+        int const *idx = asset.iV.data() + geometry.indexOffset;
+        for (size_t t = 0; t < geometry.indexCount / 3; ++t, idx += 3) {
+            if ((scene.deleted[inst.first + t] != 0) != culled) {
+                continue;
+            }
+            for (int v = 0; v < 3; ++v) {
+                fout.write((char const*)&world[3 * (idx[v] - geometry.vertexOffset)], sizeof(float) * 3);
+            }
+            byteLength += sizeof(float) * 9;
         }
     }
+    return byteLength;
+}
 
-    int IndicesAttrIndex = 0 ,meshesIndex = 0 , k= 0;  // k为存进bin的索引
-    int trianglesN = 0 ,l = 0 ;
-    // asset.newMeshes.resize(asset.meshesLength.size()) ;
-    msg("asset.newMeshes.size(): %d",asset.newMeshes.size());  
-    bool FLAG = false ;
-    int newMeshesNum = 0 ;
-
-    for(int i=0 ,j = 0; i<zbuf.scene.realworld_triangles.size(); i++){
-        FLAG = false ;
-        if(trianglesN == asset.meshesLength[j] ||  i==zbuf.scene.realworld_triangles.size()-1){
-            if(newMeshesNum != 0){
-                // asset.newMeshes[meshesIndex].name = asset.meshesName[meshesIndex] ;
-                // asset.newMeshes[meshesIndex].primitives.resize(1);
-                // asset.newMeshes[meshesIndex].primitives[0].indices = IndicesAttrIndex++ ;
-                // asset.newMeshes[meshesIndex].primitives[0].attributes["POSITION"] = IndicesAttrIndex++ ;
-                if(i != zbuf.scene.realworld_triangles.size()-1 ){
-                    k = 0 ;   //重新开始索引
-                    trianglesN = 0;
-                    meshesIndex ++ ;
-                    j++ ;
-                    FLAG = true ;
-                } 
-            }else{
-                trianglesN = 0;
-                j ++ ;
+// 按instance、primitive依次把 (是否被剔除 == culled) 的三角形的顶点索引写入bin文件
+// 顶点按三角形展开存放，每个primitive的索引都从0重新开始；
+// 每个非空primitive对应一对accessor（indices、POSITION），三角形数追加到primLength。
+// meshes不为空时为每个instance生成一个mesh，primitive与原mesh一一对应（全被剔除的略去）
+static int writeTriangleIndices(ostream &fout, gltf::Asset const &asset, Scene const &scene, bool culled,
+                                vector<int> &primLength, vector<gltf::newMesh> *meshes) {
+    int byteLength = 0;
+    int32_t accessor = 0;
+    for (size_t i = 0; i < scene.instances.size(); ++i) {
+        Instance const &inst = scene.instances[i];
+        gltf::Geometry const &geometry = asset.geometries[asset.instances[i].geometry];
+        gltf::newMesh mesh;
+        mesh.name = inst.name;
+        for (gltf::PrimitiveRange const &range : geometry.primitives) {
+            size_t first = inst.first + (range.indexOffset - geometry.indexOffset) / 3;
+            size_t last = first + range.indexCount / 3;
+            uint32_t k = 0;
+            for (size_t t = first; t < last; ++t) {
+                if ((scene.deleted[t] != 0) != culled) {
+                    continue;
+                }
+                uint32_t const index[3] = {k, k + 1, k + 2};
+                fout.write((char const*)index, sizeof(index));
+                k += 3;
             }
+            if (k == 0) {
+                continue;
+            }
+            byteLength += sizeof(uint32_t) * k;
+            primLength.push_back(k / 3);
+            gltf::Primitive primitive;
+            primitive.indices = accessor++;
+            primitive.attributes["POSITION"] = accessor++;
+            mesh.primitives.push_back(primitive);
+            msg("%d newMeshes Tris ", k / 3);
         }
-        trianglesN ++ ;
-
-        if(FLAG || i==zbuf.scene.realworld_triangles.size()-1){
-                // asset.newmeshesLength.push_back(newMeshesNum);
-                msg("%d newMeshes Tris ",newMeshesNum);
-                newMeshesNum = 0 ;
-        }
-        if(i==0)
-            msg("%d deleted?", zbuf.scene.realworld_triangles[i].deleted) ;
-        if(zbuf.scene.realworld_triangles[i].deleted != 0){
-            
-            newMeshesNum ++ ;
-            // uint16_t index = zbuf.scene.realworld_triangles[i].index_a + 1 ; 
-            uint32_t index = k ; 
-            fout.write((char*)&index,sizeof(uint32_t));  
-            index = k + 1 ;
-            fout.write((char*)&index,sizeof(uint32_t));  
-            index = k + 2 ;
-            fout.write((char*)&index,sizeof(uint32_t));
-            k += 3 ;
-            byteLengthIndexCulled += sizeof(uint32_t) * 3 ;
+        if (meshes != nullptr && !mesh.primitives.empty()) {
+            meshes->push_back(std::move(mesh));
         }
     }
+    return byteLength;
+}
+
+void outputCulledModel(gltf::Asset &asset, Zbuf &zbuf) {
+    
+    ofstream fout;
+    fout.open("./sceneTestCulled.bin", ios::out|ios::binary);        // 模型被剔除部分的bin文件
+
+    int byteLengthIndexCulled = 0, byteLengthVertexCulled = 0;        // 被剔除部分的bytelength
+    byteLengthVertexCulled = writeTrianglePositions(fout, asset, zbuf.scene, true);
+
+    vector<int> culledLength;                                         // 被剔除部分每个primitive的三角形数
+    byteLengthIndexCulled = writeTriangleIndices(fout, asset, zbuf.scene, true, culledLength, nullptr);
+    msg("culled: %zu primitives, %d bytes of positions, %d bytes of indices\n",
+        culledLength.size(), byteLengthVertexCulled, byteLengthIndexCulled);
 
     fout.close();
 }
 
-void occlusionCulling(gltf::Asset &asset) {
-
-    objl::Loader loader;
-    if (!loader.LoadFile("./scene.obj")) {
-        cout<<"objfile cannot loaded..."<<endl;
+// 创建scene：每个geometry只建一次，node作为instance引用它
+// 八叉树的根节点取三角形实际的包围盒（accessor的min/max不一定可靠）；
+// octrees不为空时（来自缓存）直接恢复各geometry的八叉树；hierarchy选择要建的层次结构
+Scene buildScene(gltf::Asset const &asset, vector<FlatOctreeView> const &octrees = {},
+                 HierarchyOptions const &hierarchy = {}) {
+    vector<pss> ranges;
+    for (gltf::Geometry const &geometry : asset.geometries) {
+        ranges.emplace_back(geometry.indexOffset, geometry.indexCount);
     }
-    
+    Scene world{asset.vV, asset.iV, ranges, octrees, hierarchy};
+    for (gltf::Instance const &instance : asset.instances) {
+        gltf::Node const &node = asset.nodes[instance.node];
+        // glTF的列主序矩阵转置后即为 homo * transform 形式
+        mat4 transform = glm::transpose(mat4(glm::make_mat4(node.worldMatrix)));
+        world.add_instance(instance.geometry, transform, node.name);
+    }
+    return world;
+}
+
+void occlusionCulling(gltf::Asset &asset, Scene const &world,
+                      rendering_method method = rendering_method::octree,
+                      bool sortPrims = false) {
+
+
     // Resolution (horizontal)
     int width = 1920;
     // Resolution (vertical)
@@ -118,10 +137,9 @@ void occlusionCulling(gltf::Asset &asset) {
                         std::tuple<flt, flt, flt> const &barycentric)>
         selected_fragment_shader = shdr::normal_shader;
 
-    // Scene world{loader.LoadedMeshes[0]};             // 1. 创建scene
-    Scene world{loader.LoadedMeshes[0],asset.meshesLength,asset.meshesName};  // 20220211 改
     Zbuf zbuf{world, static_cast<size_t>(width), static_cast<size_t>(height)};   // 2.创建zbuffer
     zbuf.set_shader(selected_fragment_shader);
+    zbuf.set_prim_sorting(sortPrims);
     // auto [eye, gaze, up] = world.generate_camera();
     vec3 pos = vec3{
         // // Viewpoint-1
@@ -134,16 +152,11 @@ void occlusionCulling(gltf::Asset &asset) {
         // this->root->maxcord[2] * 1,
         // Viewpoint-default
         
-        world.root->maxcord[0] * 1.5,
-        world.root->maxcord[1] * 2,
-        world.root->maxcord[2] * 1.2,
+        world.bounds.maxp.x * 1.5,
+        world.bounds.maxp.y * 2,
+        world.bounds.maxp.z * 1.2,
     };
-    vec3 gaze = glm::normalize(vec3{
-                              world.root->midcord[0],
-                              world.root->midcord[1],
-                              world.root->midcord[2],
-                          } -
-                          pos);
+    vec3 gaze = glm::normalize(world.bounds.centroid() - pos);
     vec3 up  = glm::normalize(vec3{
         -pos.x,
         std::fabs(gaze.y) < epsilon
@@ -161,14 +174,13 @@ void occlusionCulling(gltf::Asset &asset) {
 
     // Octree
     zbuf.reset();
-    zbuf.render(rendering_method::octree);
+    zbuf.render(method);
 
     /**
      * @brief 20220214 test
      * 测试输出deleted属性
      */
-    msg("zbuf.scene.realworld_triangles.size(): %d \n",zbuf.scene.realworld_triangles.size() );
-    // std::cout<<"zbuf.scene.realworld_triangles.size(): "<< zbuf.scene.realworld_triangles.size() << std::endl;
+    msg("zbuf.scene.deleted.size(): %d \n",zbuf.scene.deleted.size() );
     int a = 0 , b = 0;
 
     msg("%d 个 meshes ",asset.meshesLength.size());
@@ -178,90 +190,15 @@ void occlusionCulling(gltf::Asset &asset) {
     fout.open("./sceneTest.bin", ios::out|ios::binary);               // 模型剩余部分的bin文件
     int byteLengthIndex = 0 , byteLengthVertex = 0;                   // 剩余部分的byteLength
     
-    for(int i=0; i<zbuf.scene.realworld_triangles.size(); i++){
-        if(zbuf.scene.realworld_triangles[i].deleted == 0){
-            // float a = zbuf.scene.realworld_triangles[i].a()[0] ;
-            float a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_a].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_b].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.X ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.Y ;
-            fout.write((char*)&a,sizeof(float));
-            a = loader.LoadedMeshes[0].Vertices[zbuf.scene.realworld_triangles[i].index_c].Position.Z ;
-            fout.write((char*)&a,sizeof(float));
-            byteLengthVertex += sizeof(float) * 9 ;
-        }
-        
-        // msg("%d ",asset.meshesLength[j]);
-        // msg("%s ",asset.meshesName[i]);
-    }
+    byteLengthVertex = writeTrianglePositions(fout, asset, zbuf.scene, false);
     for(int i=0;i<asset.meshesLength.size();i++)
         msg("%d",asset.meshesLength[i]);   // 每个mesh的三角形数？
-    msg("%d",zbuf.scene.realworld_triangles.size());    
+    msg("%d",zbuf.scene.deleted.size());    
     
-    int IndicesAttrIndex = 0 ,meshesIndex = 0 , k= 0;  // k为存进bin的索引
-    int trianglesN = 0 ,l = 0 ;
-    asset.newMeshes.resize(asset.meshesLength.size()) ;
-    msg("asset.newMeshes.size(): %d",asset.newMeshes.size());  
-    bool FLAG = false ;
-    int newMeshesNum = 0 ;
-    for(int i=0 ,j = 0; i<zbuf.scene.realworld_triangles.size(); i++){
-        FLAG = false ;
-        if(trianglesN == asset.meshesLength[j] ||  i==zbuf.scene.realworld_triangles.size()-1){
-            if(newMeshesNum != 0){
-                asset.newMeshes[meshesIndex].name = asset.meshesName[meshesIndex] ;
-                asset.newMeshes[meshesIndex].primitives.resize(1);
-                asset.newMeshes[meshesIndex].primitives[0].indices = IndicesAttrIndex++ ;
-                asset.newMeshes[meshesIndex].primitives[0].attributes["POSITION"] = IndicesAttrIndex++ ;
-                if(i != zbuf.scene.realworld_triangles.size()-1 ){
-                    k = 0 ;   //重新开始索引
-                    trianglesN = 0;
-                    meshesIndex ++ ;
-                    j++ ;
-                    FLAG = true ;
-                } 
-            }else{
-                trianglesN = 0;
-                j ++ ;
-            }
-           
-            
-        }
-        trianglesN ++ ;
-
-        if(FLAG || i==zbuf.scene.realworld_triangles.size()-1){
-                asset.newmeshesLength.push_back(newMeshesNum);
-                msg("%d newMeshes Tris ",newMeshesNum);
-                newMeshesNum = 0 ;
-        }
-        if(i==0)
-            msg("%d deleted?", zbuf.scene.realworld_triangles[i].deleted) ;
-        if(zbuf.scene.realworld_triangles[i].deleted == 0){
-            
-            newMeshesNum ++ ;
-            // uint16_t index = zbuf.scene.realworld_triangles[i].index_a + 1 ; 
-            uint32_t index = k ; 
-            fout.write((char*)&index,sizeof(uint32_t));  
-            index = k + 1 ;
-            fout.write((char*)&index,sizeof(uint32_t));  
-            index = k + 2 ;
-            fout.write((char*)&index,sizeof(uint32_t));
-            k += 3 ;
-            byteLengthIndex += sizeof(uint32_t) * 3 ;
-        }
-        
-    }
-
+    // 每个instance一个mesh，每个primitive一对accessor
+    byteLengthIndex = writeTriangleIndices(fout, asset, zbuf.scene, false, asset.newmeshesLength, &asset.newMeshes);
+    int IndicesAttrIndex = asset.newmeshesLength.size() * 2;
+    msg("asset.newMeshes.size(): %d",asset.newMeshes.size());
 
     // new bufferviews
     asset.newBufferViews.resize(2);
@@ -299,29 +236,114 @@ void occlusionCulling(gltf::Asset &asset) {
         byteOffset1 += asset.newAccessors[i+1].count * 12 ;
     }
 
-    for(int i=0;i<5;i++){
-        msg("%f %f %f",zbuf.scene.realworld_triangles[i].a()[0],zbuf.scene.realworld_triangles[i].a()[1],zbuf.scene.realworld_triangles[i].a()[2]) ;
-        msg("%f %f %f",zbuf.scene.realworld_triangles[i].b()[0],zbuf.scene.realworld_triangles[i].b()[1],zbuf.scene.realworld_triangles[i].b()[2]) ;
-        msg("%f %f %f",zbuf.scene.realworld_triangles[i].c()[0],zbuf.scene.realworld_triangles[i].c()[1],zbuf.scene.realworld_triangles[i].c()[2]) ;
-        msg("%d %d %d\n",zbuf.scene.realworld_triangles[i].index_a,zbuf.scene.realworld_triangles[i].index_b,zbuf.scene.realworld_triangles[i].index_c) ;
+    if(!zbuf.scene.instances.empty()){
+        vector<Triangle> const &tris = zbuf.scene.geometries[zbuf.scene.instances[0].geometry].triangles;
+        for(int i=0;i<5 && i<tris.size();i++){
+            msg("%f %f %f",tris[i].a()[0],tris[i].a()[1],tris[i].a()[2]) ;
+            msg("%f %f %f",tris[i].b()[0],tris[i].b()[1],tris[i].b()[2]) ;
+            msg("%f %f %f",tris[i].c()[0],tris[i].c()[1],tris[i].c()[2]) ;
+            msg("%d %d %d\n",tris[i].index_a,tris[i].index_b,tris[i].index_c) ;
+        }
     }
 
     fout.close();
 
-    outputCulledModel(asset, zbuf, loader);
+    outputCulledModel(asset, zbuf);
 
 }
 
 int main(int argc, char *argv[]){
 
-    if(argc != 2){
-        cout<<"Usage: ./demo <model.gltf>"<<endl;
+    string modelName;
+    string cacheName;           // 默认为 <model>.occache
+    bool useCache = true;
+    bool sortPrims = false;     // 八叉树节点内的三角形按深度由近到远处理
+    gltf::LoadOptions options;
+    HierarchyOptions hierarchy;
+    rendering_method method = rendering_method::octree;
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i], "--dump-obj") == 0){
+            options.dumpObj = true;     // 输出 ./scene.obj 用于调试
+        }else if(strcmp(argv[i], "--weld") == 0){
+            options.weld = gltf::LoadOptions::Weld::Exact;
+        }else if(strcmp(argv[i], "--weld-epsilon") == 0 && i + 1 < argc){
+            options.weld = gltf::LoadOptions::Weld::Quantized;
+            options.weldEpsilon = (float)atof(argv[++i]);
+            // 量化时要除以epsilon，0、负数和无法解析的值都不接受
+            if(!(options.weldEpsilon > 0) || std::isinf(options.weldEpsilon)){
+                modelName.clear();
+                break;
+            }
+        }else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+            cacheName = argv[++i];
+        }else if(strcmp(argv[i], "--no-cache") == 0){
+            useCache = false;
+        }else if(strcmp(argv[i], "--hierarchy") == 0 && i + 1 < argc){
+            ++i;
+            if(strcmp(argv[i], "linear") == 0){
+                // 只建Morton码线性八叉树
+                hierarchy.octree = false;
+                hierarchy.linear_octree = true;
+                method = rendering_method::linear_octree;
+            }else if(strcmp(argv[i], "bvh") == 0){
+                // 只建SAH BVH
+                hierarchy.octree = false;
+                hierarchy.bvh = true;
+                method = rendering_method::bvh;
+            }else if(strcmp(argv[i], "octree") != 0){
+                modelName.clear();
+                break;
+            }
+        }else if(strcmp(argv[i], "--build-cutoff") == 0 && i + 1 < argc){
+            // 八叉树节点的三角形数不少于此值时并行构建
+            hierarchy.parallel_cutoff = strtoull(argv[++i], nullptr, 10);
+        }else if(strcmp(argv[i], "--sort-prims") == 0){
+            sortPrims = true;
+        }else if(strcmp(argv[i], "--loose") == 0 && i + 1 < argc){
+            // 松散八叉树，子节点立方体放大k倍（k >= 1）
+            hierarchy.loose = atof(argv[++i]);
+            // inf会使节点的立方体无限大，nan会被当作经典八叉树，都不接受
+            if(!(hierarchy.loose >= 1) || std::isinf(hierarchy.loose)){
+                modelName.clear();
+                break;
+            }
+        }else if(modelName.empty()){
+            modelName = argv[i];
+        }else{
+            modelName.clear();
+            break;
+        }
+    }
+    if(modelName.empty()){
+        cout<<"Usage: ./demo <model.gltf|model.glb> [--dump-obj] [--weld | --weld-epsilon <e>] [--cache <file> | --no-cache] [--hierarchy octree|linear|bvh] [--build-cutoff <n>] [--loose <k>] [--sort-prims]"<<endl;
         return 0;
     }
-    string modelName = argv[1];
+    if(cacheName.empty()){
+        cacheName = modelName + ".occache";
+    }
+    // 缓存里只存经典的指针八叉树，其他层次结构每次重建
+    if(!hierarchy.octree || hierarchy.loose > 0){
+        useCache = false;
+    }
 
+    // 先只解析JSON并计算内容哈希；缓存命中时mesh数据和八叉树都直接从缓存恢复，
+    // 否则在同一个asset上解码mesh数据（JSON只解析一次），建好scene后写入缓存。
+    // --dump-obj需要解码，不读缓存
+    Timer timer;
+    timer.start();
     gltf::Asset asset ;
-    asset = gltf::load(modelName);
+    gltf::LoadOptions jsonOnly = options;
+    jsonOnly.meshData = false;
+    asset = gltf::load(modelName, jsonOnly);
+    uint64_t key = useCache ? gltf::contentHash(asset, modelName) : 0;
+    vector<FlatOctreeView> octrees;
+    shared_ptr<const void> cacheMapping;    // octrees指向缓存文件的映射
+    bool cached = useCache && !options.dumpObj && loadSceneCache(cacheName, key, options, asset, octrees, cacheMapping);
+    if(!cached){
+        gltf::loadMeshData(asset, modelName, options);
+    }
+    msg("load: %zu vertices decoded, %zu after welding (weld ratio %.2f)\n",
+        asset.statistics.decodedVertices, asset.statistics.vertices, asset.statistics.weldRatio());
 
     // cout<<asset.dirName<<endl<<asset.metadata.generator<<endl<<asset.metadata.version<<endl;
     // // nodes test
@@ -352,7 +374,15 @@ int main(int argc, char *argv[]){
 
     // cout<<"\n================================"<<endl;
     
-    occlusionCulling(asset);   // 处理遮挡剔除并输出'.bin'文件
+    Scene world = buildScene(asset, octrees, hierarchy);
+    timer.end();
+    msg("scene ready in %.1f ms (%s)\n", timer.elapsedms(),
+        cached ? "from cache" : useCache ? "cache miss" : "cache disabled");
+    if(useCache && !cached && !saveSceneCache(cacheName, key, options, asset, world)){
+        msg("can't write scene cache '%s'\n", cacheName.c_str());
+    }
+
+    occlusionCulling(asset, world, method, sortPrims);   // 处理遮挡剔除并输出'.bin'文件
 
     cout<<"aaaaa"<<endl;
     cout<<"bbbbb"<<endl;